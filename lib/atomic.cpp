@@ -37,6 +37,33 @@ bool check_cmpxchg16b_support() {
 #endif
 }
 
+bool cmpxchg16b(uint128_t* addr, uint128_t& expected, uint128_t desired) noexcept {
+    bool result;
+    uint64_t current_lower, current_upper;
+    
+    asm volatile(
+        "lock; cmpxchg16b %[value]\n"  // Compare and exchange 16 bytes
+        "setz %[result]\n"              // Set result based on success
+        : [result]"=q"(result),
+          [value]"+m"(*addr),
+          "=a"(current_lower),          // RAX gets current lower value on failure
+          "=d"(current_upper)           // RDX gets current upper value on failure
+        : "a"(expected.lower),          // RAX holds expected lower value
+          "d"(expected.upper),          // RDX holds expected upper value
+          "b"(desired.lower),           // RBX holds desired lower value
+          "c"(desired.upper)            // RCX holds desired upper value
+        : "cc", "memory"                // Clobbers condition codes and memory
+    );
+    
+    // only touch expected on failure: on success it may live in memory that another
+    // thread already owns (e.g. the next field of a freshly published stack node)
+    if (!result) {
+        expected.lower = current_lower;
+        expected.upper = current_upper;
+    }
+    return result;
+}
+
 // Specialized atomic implementation for uint128_t
 constexpr std::atomic<uint128_t>::atomic(uint128_t desired) noexcept : value_(desired) {}
 
@@ -49,13 +76,16 @@ uint128_t std::atomic<uint128_t>::load(std::memory_order order) const noexcept {
     static_assert(alignof(uint128_t) >= 16, "uint128_t must be 16-byte aligned");
     uint128_t result;
     
-    // Ensure we read the entire 128 bits atomically
+    // Ensure we read the entire 128 bits atomically.
+    // RDX:RAX and RCX:RBX are both 0, so a matching value is rewritten unchanged.
     asm volatile(
-        "lock; cmpxchg16b %1\n"  // Use CMPXCHG16B for atomic read
-        : "=A"(result)           // Output to result through EDX:EAX
-        : "m"(value_),           // Memory operand
-          "c"(0), "b"(0)         // Clear RCX:RBX as we don't need them
-        : "memory"
+        "lock; cmpxchg16b %[value]\n"  // Use CMPXCHG16B for atomic read
+        : [value]"+m"(const_cast<uint128_t&>(value_)),
+          "=a"(result.lower),            // RAX gets current lower value
+          "=d"(result.upper)             // RDX gets current upper value
+        : "a"(0), "d"(0),                // Expect 0 in RDX:RAX
+          "c"(0), "b"(0)                 // and store 0 back from RCX:RBX
+        : "cc", "memory"
     );
     return result;
 }
@@ -76,21 +106,5 @@ bool std::atomic<uint128_t>::compare_exchange_strong(uint128_t& expected, uint12
         std::cerr << "Warning: CMPXCHG16B not supported, atomic operations may not be reliable\n";
     }
     
-    bool result;
-    
-    asm volatile(
-        "lock; cmpxchg16b %[value]\n"  // Compare and exchange 16 bytes
-        "setz %[result]\n"              // Set result based on success
-        : [result]"=q"(result),
-          [value]"+m"(value_),
-          "=a"(expected.lower),         // RAX gets current lower value on failure
-          "=d"(expected.upper)          // RDX gets current upper value on failure
-        : "a"(expected.lower),          // RAX holds expected lower value
-          "d"(expected.upper),          // RDX holds expected upper value
-          "b"(desired.lower),           // RBX holds desired lower value
-          "c"(desired.upper)            // RCX holds desired upper value
-        : "cc", "memory"                // Clobbers condition codes and memory
-    );
-    
-    return result;
+    return cmpxchg16b(&value_, expected, desired);
 }
\ No newline at end of file
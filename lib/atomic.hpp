@@ -32,6 +32,13 @@ struct alignas(16) uint128_t {
     constexpr uint128_t(uint64_t lower, uint64_t upper): lower(lower), upper(upper) {};
 };
 
+// Raw 16-byte compare-and-swap (lock cmpxchg16b) on plain memory.
+// This is the primitive behind atomic<uint128_t>; it is exposed for structures whose
+// 16-byte words are also read as two separate 64-bit halves (e.g. LCRQ cells).
+// @param addr: must be 16-byte aligned
+// @note on failure `expected` receives the current value, on success it is left untouched
+bool cmpxchg16b(uint128_t* addr, uint128_t& expected, uint128_t desired) noexcept;
+
 // Forward declaration of the specialized atomic implementation
 namespace std {
     template<>
@@ -0,0 +1,393 @@
+/*
+ * This file is part of a project licensed under the GNU General Public License v3.0.
+ *
+ * Copyright (C) 2025 ZHENYU CHEN
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "rcu.hpp"
+
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rcu_detail {
+
+alignas(RCU_CACHE_LINE_SIZE) std::atomic<uint64_t> g_epoch {1};
+bool g_has_membarrier = false;
+
+namespace {
+
+    // a run of one thread's call_rcu callbacks
+    struct CallbackBlock {
+        std::array<std::function<void()>, RCU_BATCH_SIZE> fns;
+        std::atomic<CallbackBlock*> next {nullptr}; // linked before anything in it is published
+    };
+
+    // a thread's call_rcu queue: a single-producer list of blocks. The owner appends and
+    // publishes with plain stores, the reclaimer takes from the front, so queueing a
+    // callback does no read-modify-write and touches no line other threads write.
+    struct CallbackQueue {
+        CallbackBlock* tail; // owner only
+        size_t tail_used = 0; // owner only: fns of tail in use
+        size_t unsignalled = 0; // owner only: callbacks queued since the owner last woke the reclaimer
+
+        std::atomic<uint64_t> published {0}; // callbacks ever queued, written by the owner only
+        std::atomic<bool> orphaned {false}; // the owner has exited
+
+        alignas(RCU_CACHE_LINE_SIZE) CallbackBlock* head; // reclaimer only
+        size_t head_taken = 0; // reclaimer only: fns of head already taken
+        uint64_t taken = 0; // reclaimer only: callbacks ever taken
+
+        CallbackQueue(): tail(new CallbackBlock), head(tail) {}
+        ~CallbackQueue() { delete head; }
+    };
+
+    struct Registry {
+        std::mutex gp_mutex; // serializes grace periods and guards readers
+        std::vector<std::unique_ptr<ReaderState>> readers;
+
+        std::mutex queues_mutex; // guards queues
+        std::vector<CallbackQueue*> queues;
+
+        std::mutex wake_mutex; // guards requests and served
+        std::condition_variable wake_cv; // the reclaimer waits here
+        std::condition_variable done_cv; // rcu_barrier waits here
+        uint64_t requests = 0; // bumped to wake the reclaimer
+        uint64_t served = 0; // requests seen by the last finished reclaim cycle
+
+        std::atomic<bool> idle {false}; // the reclaimer sleeps without a timeout
+    };
+
+    // never destroyed: threads may exit (and unregister) after static destruction
+    Registry& registry() {
+        static Registry* instance = new Registry;
+        return *instance;
+    }
+
+    // decide once, before the first reader exists, which fence flavour readers use
+    void init_membarrier() {
+        static const bool once = []() {
+            long cmds = syscall(SYS_membarrier, MEMBARRIER_CMD_QUERY, 0);
+            if (cmds >= 0 and (cmds & MEMBARRIER_CMD_PRIVATE_EXPEDITED)
+                and syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0) == 0) {
+                g_has_membarrier = true;
+            }
+            return true;
+        }();
+        (void)once;
+    }
+
+    // the writer half of reader_fence
+    void writer_fence() {
+        if (g_has_membarrier) {
+            syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0);
+        } else {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+
+    // unregisters the owning thread's ReaderState at thread exit
+    struct Registration {
+        ReaderState* state = nullptr;
+
+        ~Registration() {
+            if (state == nullptr) return;
+            auto& reg = registry();
+            std::lock_guard<std::mutex> lock(reg.gp_mutex);
+            auto it = std::find_if(reg.readers.begin(), reg.readers.end(),
+                                   [this](const auto& r) { return r.get() == state; });
+            if (it != reg.readers.end()) reg.readers.erase(it);
+            t_reader = nullptr;
+        }
+    };
+
+    thread_local Registration t_registration;
+
+    // constant initialized, see t_reader
+    thread_local CallbackQueue* t_queue = nullptr;
+
+    // hands the owning thread's queue to the reclaimer at thread exit
+    struct QueueOwner {
+        CallbackQueue* queue = nullptr;
+
+        ~QueueOwner() {
+            if (queue == nullptr) return;
+            queue->orphaned.store(true, std::memory_order_release);
+            t_queue = nullptr;
+        }
+    };
+
+    thread_local QueueOwner t_queue_owner;
+
+    void wait_for_readers(uint64_t target) {
+        for (auto& reader : registry().readers) {
+            for (int spins = 0; ; ++spins) {
+                auto epoch = reader->epoch.load(std::memory_order_acquire);
+                if (epoch == 0 or epoch >= target) break;
+                if (spins < 128) {
+                    __builtin_ia32_pause();
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+
+    thread_local bool t_is_reclaimer = false;
+
+    // callbacks [begin, end) of one block, taken in one go
+    struct Range {
+        CallbackBlock* block;
+        size_t begin;
+        size_t end;
+        bool last; // nothing else refers to the block: free it once the range has run
+    };
+
+    // ranges whose grace period has passed. Only the reclaimer thread uses it (so it is
+    // not destroyed at exit under the detached reclaimer); it lives outside reclaim_pending
+    // so a callback calling rcu_barrier can finish the rest of the batch it belongs to.
+    thread_local std::deque<Range> t_ready;
+
+    void run_ready() {
+        while (not t_ready.empty()) {
+            // take the callback out first: a nested rcu_barrier continues after it and
+            // may free the block while it runs
+            auto& range = t_ready.front();
+            auto fn = std::move(range.block->fns[range.begin++]);
+            if (range.begin == range.end) {
+                if (range.last) delete range.block;
+                t_ready.pop_front();
+            }
+            fn();
+        }
+    }
+
+    // append the callbacks `queue` has published so far to `out`, oldest first
+    // @return if the owner has exited and the queue is now empty for good
+    bool take_from(CallbackQueue& queue, std::vector<Range>& out) {
+        // read before `published`: everything an exited owner queued is published by now
+        bool orphaned = queue.orphaned.load(std::memory_order_acquire);
+        // a snapshot, so a busy owner can't keep us here
+        auto published = queue.published.load(std::memory_order_acquire);
+        while (queue.taken < published) {
+            if (queue.head_taken == RCU_BATCH_SIZE) {
+                auto* next = queue.head->next.load(std::memory_order_acquire);
+                if (not out.empty() and out.back().block == queue.head) {
+                    out.back().last = true;
+                } else {
+                    delete queue.head; // everything in it has run in an earlier cycle
+                }
+                queue.head = next;
+                queue.head_taken = 0;
+            }
+            auto count = std::min<uint64_t>(RCU_BATCH_SIZE - queue.head_taken, published - queue.taken);
+            out.push_back({queue.head, queue.head_taken, size_t(queue.head_taken + count), false});
+            queue.head_taken += count;
+            queue.taken += count;
+        }
+        return orphaned;
+    }
+
+    // take everything queued so far, wait one grace period and run it, each thread's
+    // callbacks in call order
+    // @return if anything was queued
+    bool reclaim_pending() {
+        auto& reg = registry();
+        std::vector<Range> batch;
+        {
+            std::lock_guard<std::mutex> lock(reg.queues_mutex);
+            for (auto it = reg.queues.begin(); it != reg.queues.end();) {
+                auto* queue = *it;
+                if (not take_from(*queue, batch)) {
+                    ++it;
+                    continue;
+                }
+                // the owner is gone: its last block goes with the last range taken from it
+                if (not batch.empty() and batch.back().block == queue->head) {
+                    batch.back().last = true;
+                    queue->head = nullptr;
+                }
+                delete queue;
+                it = reg.queues.erase(it);
+            }
+        }
+        if (batch.empty()) return false;
+
+        synchronize_rcu();
+        t_ready.insert(t_ready.end(), batch.begin(), batch.end());
+        run_ready();
+        return true;
+    }
+
+    // untimed condition wait. Built on wait_for because the out-of-line
+    // condition_variable::wait changed symbol version in libstdc++ 12, which would tie
+    // the library to a newer runtime than everything else here needs.
+    template <typename Predicate>
+    void wait_for_condition(std::condition_variable& cv, std::unique_lock<std::mutex>& lock, Predicate predicate) {
+        while (not cv.wait_for(lock, std::chrono::hours(1), predicate));
+    }
+
+    // grace periods are paid here, never on the thread calling call_rcu
+    void reclaimer_loop() {
+        t_is_reclaimer = true;
+        auto& reg = registry();
+        std::unique_lock<std::mutex> lock(reg.wake_mutex);
+        uint64_t seen = 0;
+        while (true) {
+            auto woken = [&]() { return reg.requests != seen; };
+            if (reg.idle.load(std::memory_order_relaxed)) {
+                wait_for_condition(reg.wake_cv, lock, woken);
+            } else {
+                // callbacks below a full batch don't wake us, so look at least this often
+                reg.wake_cv.wait_for(lock, RCU_FLUSH_INTERVAL, woken);
+            }
+            seen = reg.requests;
+            reg.idle.store(false, std::memory_order_relaxed);
+            lock.unlock();
+
+            if (not reclaim_pending()) {
+                // nothing left: sleep until a call_rcu wakes us. Pairs with the
+                // reader_fence in call_rcu, so either it sees idle or we see its callback.
+                reg.idle.store(true, std::memory_order_relaxed);
+                writer_fence();
+                if (reclaim_pending()) reg.idle.store(false, std::memory_order_relaxed);
+            }
+
+            lock.lock();
+            reg.served = seen;
+            reg.done_cv.notify_all();
+        }
+    }
+
+    void start_reclaimer() {
+        static std::once_flag once;
+        std::call_once(once, []() { std::thread(reclaimer_loop).detach(); });
+    }
+
+    void wake_reclaimer() {
+        auto& reg = registry();
+        {
+            std::lock_guard<std::mutex> lock(reg.wake_mutex);
+            ++reg.requests;
+        }
+        reg.wake_cv.notify_one();
+    }
+
+    CallbackQueue* register_queue() {
+        init_membarrier();
+        start_reclaimer();
+        auto& reg = registry();
+        auto* queue = new CallbackQueue;
+        {
+            std::lock_guard<std::mutex> lock(reg.queues_mutex);
+            reg.queues.push_back(queue);
+        }
+        t_queue_owner.queue = queue;
+        t_queue = queue;
+        return queue;
+    }
+}
+
+ReaderState* register_thread() {
+    init_membarrier();
+    auto& reg = registry();
+    auto state = std::make_unique<ReaderState>();
+    {
+        std::lock_guard<std::mutex> lock(reg.gp_mutex);
+        reg.readers.push_back(std::move(state));
+        t_reader = reg.readers.back().get();
+    }
+    t_registration.state = t_reader;
+    return t_reader;
+}
+
+}
+
+void synchronize_rcu() {
+    using namespace rcu_detail;
+    assert(not rcu_in_read_section() && "synchronize_rcu inside a read-side section would deadlock");
+
+    init_membarrier();
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.gp_mutex);
+
+    // make the caller's unpublish visible to, and every reader's slot store visible to us
+    writer_fence();
+    auto target = g_epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+    wait_for_readers(target);
+}
+
+void call_rcu(std::function<void()> callback) {
+    using namespace rcu_detail;
+    auto* queue = t_queue;
+    if (queue == nullptr) [[unlikely]] {
+        queue = register_queue();
+    }
+
+    if (queue->tail_used == RCU_BATCH_SIZE) {
+        auto* fresh = new CallbackBlock;
+        queue->tail->next.store(fresh, std::memory_order_release);
+        queue->tail = fresh;
+        queue->tail_used = 0;
+    }
+    queue->tail->fns[queue->tail_used++] = std::move(callback);
+    // we are the only writer, so no read-modify-write is needed
+    queue->published.store(queue->published.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+    if (++queue->unsignalled == RCU_BATCH_SIZE) {
+        queue->unsignalled = 0;
+        wake_reclaimer();
+        return;
+    }
+    // an idle reclaimer has no timeout, so the first callback after a quiet period wakes it
+    reader_fence();
+    if (registry().idle.load(std::memory_order_relaxed)) [[unlikely]] {
+        wake_reclaimer();
+    }
+}
+
+void rcu_barrier() {
+    using namespace rcu_detail;
+    assert(not rcu_in_read_section() && "rcu_barrier inside a read-side section would deadlock");
+
+    if (t_is_reclaimer) {
+        // called from a callback: we can't wait for our own cycle, so finish the batch
+        // we are part of and drain the queues inline instead
+        run_ready();
+        reclaim_pending();
+        return;
+    }
+
+    start_reclaimer();
+    auto& reg = registry();
+    std::unique_lock<std::mutex> lock(reg.wake_mutex);
+
+    // the cycle that sees this request takes the queues after every call_rcu that
+    // happened before us, and runs after the cycles that may hold earlier batches
+    auto target = ++reg.requests;
+    reg.wake_cv.notify_one();
+    wait_for_condition(reg.done_cv, lock, [&]() { return reg.served >= target; });
+}
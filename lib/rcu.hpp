@@ -0,0 +1,206 @@
+/*
+ * This file is part of a project licensed under the GNU General Public License v3.0.
+ *
+ * Copyright (C) 2025 ZHENYU CHEN
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+// can use std::hardware_destructive_interference_size in #include<new> if it is supported
+#define RCU_CACHE_LINE_SIZE 64
+
+/** userspace rcu for read-mostly data.
+ *
+ * Every reader thread owns a cache-line sized slot. rcu_read_lock publishes the current
+ * global epoch in that slot, rcu_read_unlock clears it, and a slot holding 0 means the
+ * thread is in a quiescent state. synchronize_rcu bumps the epoch and waits until every
+ * slot is either quiescent or has observed the new epoch, i.e. until every reader that
+ * could still see the old data has left its critical section.
+ *
+ * The store->load ordering a reader needs (slot store before reading the protected
+ * pointer) is paid by the writer through membarrier(MEMBARRIER_CMD_PRIVATE_EXPEDITED),
+ * so the read side is a thread-local store plus a compiler barrier. On kernels without
+ * expedited membarrier the reader falls back to a full fence.
+ *
+ * @note read-side sections nest.
+ * @note synchronize_rcu and rcu_barrier must not be called inside a read-side section.
+ */
+
+namespace rcu_detail {
+
+    struct alignas(RCU_CACHE_LINE_SIZE) ReaderState {
+        std::atomic<uint64_t> epoch {0}; // 0 == quiescent, otherwise epoch seen at outermost lock
+        unsigned nest {0}; // only touched by the owning thread
+    };
+
+    extern std::atomic<uint64_t> g_epoch;
+    extern bool g_has_membarrier;
+
+    // constant initialized, so access does not go through a tls wrapper
+    inline thread_local ReaderState* t_reader = nullptr;
+
+    // registers the calling thread as a reader. Unregistered automatically at thread exit.
+    ReaderState* register_thread();
+
+    inline void reader_fence() noexcept {
+        if (g_has_membarrier) [[likely]] {
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+        } else {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+}
+
+// number of call_rcu callbacks a thread queues before it wakes the reclaimer
+constexpr size_t RCU_BATCH_SIZE = 128;
+
+// longest a smaller batch waits for the reclaimer to collect it while the reclaimer is active
+constexpr std::chrono::milliseconds RCU_FLUSH_INTERVAL {5};
+
+inline void rcu_read_lock() noexcept {
+    auto* self = rcu_detail::t_reader;
+    if (self == nullptr) [[unlikely]] {
+        self = rcu_detail::register_thread();
+    }
+    if (self->nest++ == 0) {
+        self->epoch.store(rcu_detail::g_epoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        rcu_detail::reader_fence();
+    }
+}
+
+inline void rcu_read_unlock() noexcept {
+    auto* self = rcu_detail::t_reader;
+    if (--self->nest == 0) {
+        // release: every load of the section completes before we report quiescence
+        self->epoch.store(0, std::memory_order_release);
+    }
+}
+
+// @return if the calling thread is inside a read-side section
+inline bool rcu_in_read_section() noexcept {
+    auto* self = rcu_detail::t_reader;
+    return self != nullptr and self->nest > 0;
+}
+
+// block until every read-side section that was active at the time of the call has ended
+void synchronize_rcu();
+
+/**
+ * run `callback` after a grace period.
+ * Only appends to the calling thread's own queue: grace periods and callbacks run on a
+ * background reclaimer thread, so the caller never blocks on readers. A thread wakes the
+ * reclaimer once per RCU_BATCH_SIZE callbacks, or on its first callback while the
+ * reclaimer is idle; an active reclaimer collects every queue at least every
+ * RCU_FLUSH_INTERVAL. One grace period covers everything collected at once.
+ * Safe to call inside a read-side section.
+ * @note callbacks queued by one thread run in call order; there is no order across threads.
+ */
+void call_rcu(std::function<void()> callback);
+
+/**
+ * block until every callback queued before the call has run, including batches the
+ * reclaimer already took and is still processing.
+ * @note called from a callback it runs the rest of that callback's batch and drains the
+ *       queue inline instead of waiting.
+ */
+void rcu_barrier();
+
+// RAII read-side section
+struct rcu_read_guard {
+    rcu_read_guard() noexcept { rcu_read_lock(); }
+    ~rcu_read_guard() { rcu_read_unlock(); }
+
+    rcu_read_guard(const rcu_read_guard&) = delete;
+    rcu_read_guard& operator=(const rcu_read_guard&) = delete;
+};
+
+/**
+ * owning pointer to rcu-protected data.
+ * Readers call get() inside a read-side section; writers publish a new object with
+ * replace() / update(), and the old one is deleted once no reader can hold it.
+ * @note the destructor deletes the current object directly, so no reader may be using it.
+ */
+template <typename T>
+class rcu_ptr {
+private:
+    std::atomic<T*> m_ptr;
+
+public:
+    rcu_ptr() noexcept: m_ptr(nullptr) {}
+    explicit rcu_ptr(T* ptr) noexcept: m_ptr(ptr) {}
+
+    rcu_ptr(const rcu_ptr&) = delete;
+    rcu_ptr& operator=(const rcu_ptr&) = delete;
+
+    ~rcu_ptr() {
+        delete m_ptr.load(std::memory_order_relaxed);
+    }
+
+    // @return the current object. Only valid until the enclosing read-side section ends.
+    T* get() const noexcept {
+        return m_ptr.load(std::memory_order_acquire);
+    }
+
+    /**
+     * publish `ptr` and hand back the previous object.
+     * @note the caller owns the result and must wait for a grace period before freeing it.
+     */
+    T* exchange(T* ptr) noexcept {
+        return m_ptr.exchange(ptr, std::memory_order_acq_rel);
+    }
+
+    // publish `ptr`; the previous object is deleted through call_rcu
+    void replace(T* ptr) {
+        T* old = exchange(ptr);
+        if (old != nullptr) call_rcu([old]() { delete old; });
+    }
+
+    // publish `ptr`, wait for a grace period and delete the previous object
+    void replace_sync(T* ptr) {
+        T* old = exchange(ptr);
+        synchronize_rcu();
+        delete old;
+    }
+
+    /**
+     * read-copy-update: copy the current object, apply `fn` to the copy and publish it.
+     * Concurrent updaters are resolved with a CAS, the loser retries on the new version.
+     * @note requires a non-null current object.
+     */
+    template <typename F>
+    void update(F&& fn) {
+        T* old;
+        T* next;
+        {
+            rcu_read_guard guard;
+            old = get();
+            while (true) {
+                next = new T(*old);
+                fn(*next);
+                if (m_ptr.compare_exchange_strong(old, next, std::memory_order_acq_rel, std::memory_order_acquire)) break;
+                delete next;
+            }
+        }
+        call_rcu([old]() { delete old; });
+    }
+};
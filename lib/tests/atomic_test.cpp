@@ -2,6 +2,8 @@
 #include <gtest/gtest.h>
 #include <thread>
 #include <vector>
+#include <sys/mman.h>
+#include <unistd.h>
 
 class AtomicUInt128Test : public ::testing::Test {
 protected:
@@ -83,6 +85,57 @@ TEST_F(AtomicUInt128Test, ConcurrentIncrements) {
     EXPECT_EQ(final_val.upper, 0);
 }
 
+TEST_F(AtomicUInt128Test, CompareExchangeSuccessLeavesExpectedUntouched) {
+    std::atomic<uint128_t> atomic_val;
+    atomic_val.store({1, 1});
+
+    // put `expected` on a read-only page: any write-back on success would fault
+    size_t page = size_t(sysconf(_SC_PAGESIZE));
+    void* mem = mmap(nullptr, page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ASSERT_NE(mem, MAP_FAILED);
+    auto* expected = new (mem) uint128_t(1, 1);
+    ASSERT_EQ(mprotect(mem, page, PROT_READ), 0);
+
+    EXPECT_TRUE(atomic_val.compare_exchange_strong(*expected, {2, 2}));
+    EXPECT_EQ(expected->lower, 1);
+    EXPECT_EQ(expected->upper, 1);
+
+    munmap(mem, page);
+    uint128_t final_val = atomic_val.load();
+    EXPECT_EQ(final_val.lower, 2);
+    EXPECT_EQ(final_val.upper, 2);
+}
+
+TEST_F(AtomicUInt128Test, LoadNeverModifiesValue) {
+    std::atomic<uint128_t> atomic_val;
+    atomic_val.store({0, 0});
+    EXPECT_EQ(atomic_val.load().lower, 0);
+    EXPECT_EQ(atomic_val.load().upper, 0);
+
+    // loads racing with CAS increments must neither lose nor reset any increment
+    std::atomic<bool> done(false);
+    std::thread loader([&]() {
+        uint64_t last = 0;
+        while (!done) {
+            uint128_t val = atomic_val.load();
+            EXPECT_GE(val.lower, last);
+            EXPECT_EQ(val.lower, val.upper);
+            last = val.lower;
+        }
+    });
+
+    for (size_t i = 0; i < NUM_THREADS * ITERATIONS; ++i) {
+        uint128_t expected = atomic_val.load();
+        while (!atomic_val.compare_exchange_strong(expected, {expected.lower + 1, expected.upper + 1}));
+    }
+    done = true;
+    loader.join();
+
+    uint128_t final_val = atomic_val.load();
+    EXPECT_EQ(final_val.lower, NUM_THREADS * ITERATIONS);
+    EXPECT_EQ(final_val.upper, NUM_THREADS * ITERATIONS);
+}
+
 int main(int argc, char **argv) {
     testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
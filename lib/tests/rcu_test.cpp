@@ -0,0 +1,239 @@
+#include "rcu.hpp"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+class RcuTest : public ::testing::Test {
+protected:
+    static constexpr size_t NUM_READERS = 4;
+    static constexpr uint64_t ITERATIONS = 2000;
+
+    void TearDown() override {
+        rcu_barrier();
+    }
+};
+
+TEST_F(RcuTest, ReadSectionNests) {
+    EXPECT_FALSE(rcu_in_read_section());
+    rcu_read_lock();
+    rcu_read_lock();
+    EXPECT_TRUE(rcu_in_read_section());
+    rcu_read_unlock();
+    EXPECT_TRUE(rcu_in_read_section());
+    rcu_read_unlock();
+    EXPECT_FALSE(rcu_in_read_section());
+
+    {
+        rcu_read_guard guard;
+        EXPECT_TRUE(rcu_in_read_section());
+    }
+    EXPECT_FALSE(rcu_in_read_section());
+}
+
+TEST_F(RcuTest, SynchronizeWithoutReaders) {
+    synchronize_rcu();
+    synchronize_rcu();
+}
+
+TEST_F(RcuTest, SynchronizeWaitsForActiveReader) {
+    std::atomic<bool> in_section(false);
+    std::atomic<bool> release(false);
+    std::atomic<bool> synchronized(false);
+
+    std::thread reader([&]() {
+        rcu_read_lock();
+        in_section = true;
+        while (!release) std::this_thread::yield();
+        // the writer must still be blocked while we are inside the section
+        EXPECT_FALSE(synchronized.load());
+        rcu_read_unlock();
+    });
+
+    while (!in_section) std::this_thread::yield();
+
+    std::thread writer([&]() {
+        synchronize_rcu();
+        synchronized = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(synchronized.load());
+    release = true;
+
+    reader.join();
+    writer.join();
+    EXPECT_TRUE(synchronized.load());
+}
+
+TEST_F(RcuTest, CallRcuRunsAfterBarrier) {
+    std::atomic<int> ran(0);
+    for (int i = 0; i < 10; ++i) {
+        call_rcu([&]() { ran.fetch_add(1); });
+    }
+    rcu_barrier();
+    EXPECT_EQ(ran.load(), 10);
+}
+
+TEST_F(RcuTest, CallRcuBatches) {
+    std::atomic<size_t> ran(0);
+    for (size_t i = 0; i < RCU_BATCH_SIZE; ++i) {
+        call_rcu([&]() { ran.fetch_add(1); });
+    }
+    // filling the batch wakes the reclaimer without anyone calling rcu_barrier
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (ran.load() < RCU_BATCH_SIZE && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(ran.load(), RCU_BATCH_SIZE);
+}
+
+TEST_F(RcuTest, SingleCallbackRunsWithoutBarrier) {
+    // far below a full batch, so only the reclaimer's own flush can run these
+    for (int round = 0; round < 3; ++round) {
+        std::atomic<bool> ran(false);
+        call_rcu([&]() { ran = true; });
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (!ran && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        ASSERT_TRUE(ran.load()) << "round " << round;
+        // let the reclaimer go idle again before the next round
+        std::this_thread::sleep_for(RCU_FLUSH_INTERVAL * 4);
+    }
+}
+
+TEST_F(RcuTest, BarrierWaitsForInFlightBatches) {
+    std::atomic<bool> stop(false);
+    std::atomic<size_t> noise(0);
+
+    // keeps the reclaimer busy with batches taken before our barrier starts
+    std::thread retirer([&]() {
+        while (!stop) {
+            call_rcu([&]() { noise.fetch_add(1); });
+        }
+    });
+
+    for (int i = 0; i < 200; ++i) {
+        std::atomic<bool> ran(false);
+        call_rcu([&]() { ran = true; });
+        rcu_barrier();
+        ASSERT_TRUE(ran.load()) << "iteration " << i;
+    }
+
+    stop = true;
+    retirer.join();
+    rcu_barrier(); // the noise callbacks reference locals of this test
+}
+
+TEST_F(RcuTest, BarrierFromCallbackDoesNotDeadlock) {
+    std::atomic<bool> inner(false);
+    call_rcu([&]() {
+        call_rcu([&]() { inner = true; });
+        rcu_barrier();
+    });
+    rcu_barrier();
+    EXPECT_TRUE(inner.load());
+}
+
+TEST_F(RcuTest, BarrierFromCallbackFinishesItsBatch) {
+    for (int round = 0; round < 50; ++round) {
+        std::atomic<bool> later(false);
+        std::atomic<bool> saw_later(false);
+        {
+            // keeps the first callback from running before the second is queued
+            rcu_read_guard guard;
+            call_rcu([&]() {
+                rcu_barrier();
+                saw_later = later.load();
+            });
+            call_rcu([&]() { later = true; });
+        }
+        rcu_barrier();
+        ASSERT_TRUE(saw_later.load()) << "round " << round;
+    }
+}
+
+TEST_F(RcuTest, CallRcuInsideReadSectionDefers) {
+    std::atomic<size_t> ran(0);
+    {
+        rcu_read_guard guard;
+        for (size_t i = 0; i < RCU_BATCH_SIZE * 2; ++i) {
+            call_rcu([&]() { ran.fetch_add(1); });
+        }
+        EXPECT_EQ(ran.load(), 0);
+    }
+    rcu_barrier();
+    EXPECT_EQ(ran.load(), RCU_BATCH_SIZE * 2);
+}
+
+TEST_F(RcuTest, RcuPtrReplace) {
+    rcu_ptr<int> ptr(new int(1));
+    {
+        rcu_read_guard guard;
+        EXPECT_EQ(*ptr.get(), 1);
+    }
+    ptr.replace(new int(2));
+    ptr.replace_sync(new int(3));
+    ptr.update([](int& v) { v += 1; });
+
+    rcu_read_guard guard;
+    EXPECT_EQ(*ptr.get(), 4);
+}
+
+struct Route {
+    static constexpr uint64_t ALIVE = 0x600d600d600d600d;
+    static constexpr uint64_t DEAD = 0xdeaddeaddeaddead;
+
+    uint64_t canary = ALIVE;
+    uint64_t version;
+
+    explicit Route(uint64_t version): version(version) {}
+    Route(const Route&) = default;
+    ~Route() { canary = DEAD; }
+};
+
+TEST_F(RcuTest, ConcurrentReadersNeverSeeFreedData) {
+    rcu_ptr<Route> route(new Route(0));
+    std::atomic<bool> done(false);
+    std::atomic<size_t> reads(0);
+    std::vector<std::thread> readers;
+
+    for (size_t i = 0; i < NUM_READERS; ++i) {
+        readers.emplace_back([&]() {
+            uint64_t last = 0;
+            while (!done) {
+                rcu_read_guard guard;
+                Route* r = route.get();
+                ASSERT_EQ(r->canary, Route::ALIVE);
+                ASSERT_GE(r->version, last); // versions only move forward
+                last = r->version;
+                reads.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    for (uint64_t v = 1; v <= ITERATIONS; ++v) {
+        if (v % 2) {
+            route.replace(new Route(v));
+        } else {
+            route.update([v](Route& r) { r.version = v; });
+        }
+        if (v % 64 == 0) std::this_thread::yield();
+    }
+    done = true;
+
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    rcu_read_guard guard;
+    EXPECT_EQ(route.get()->version, ITERATIONS);
+    EXPECT_GT(reads.load(), 0);
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
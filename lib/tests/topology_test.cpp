@@ -0,0 +1,163 @@
+#include "topology.hpp"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+TEST(TopologyTest, ParseCpuList) {
+    EXPECT_EQ(topology::parse_cpu_list("0"), std::vector<int>({0}));
+    EXPECT_EQ(topology::parse_cpu_list("0-3"), std::vector<int>({0, 1, 2, 3}));
+    EXPECT_EQ(topology::parse_cpu_list("0-1,4,6-7"), std::vector<int>({0, 1, 4, 6, 7}));
+    EXPECT_EQ(topology::parse_cpu_list("3,1-2\n"), std::vector<int>({1, 2, 3}));
+    EXPECT_TRUE(topology::parse_cpu_list("").empty());
+    EXPECT_TRUE(topology::parse_cpu_list("5-2").empty());
+}
+
+TEST(TopologyTest, NodesAndCpusAreConsistent) {
+    ASSERT_GE(topology::node_count(), 1);
+    ASSERT_EQ(topology::nodes().size(), topology::node_count());
+
+    size_t cpus = 0;
+    for (int node : topology::nodes()) {
+        EXPECT_EQ(topology::distance(node, node), 10);
+        for (int cpu : topology::cpus_of_node(node)) {
+            EXPECT_EQ(topology::node_of_cpu(cpu), node);
+            ++cpus;
+        }
+    }
+    EXPECT_EQ(cpus, topology::cpu_count());
+    EXPECT_TRUE(topology::cpus_of_node(-1).empty());
+    EXPECT_EQ(topology::node_of_cpu(-1), -1);
+}
+
+TEST(TopologyTest, CurrentNodeIsOnline) {
+    const auto& nodes = topology::nodes();
+    EXPECT_NE(std::find(nodes.begin(), nodes.end(), topology::current_node()), nodes.end());
+}
+
+TEST(TopologyTest, PinThread) {
+    int node = topology::nodes().front();
+    int cpu = topology::cpus_of_node(node).front();
+
+    std::thread worker([&]() {
+        ASSERT_TRUE(topology::pin_thread_to_cpu(cpu));
+        EXPECT_EQ(topology::current_cpu(), cpu);
+        ASSERT_TRUE(topology::pin_thread_to_node(node));
+        EXPECT_EQ(topology::current_node(), node);
+    });
+    worker.join();
+}
+
+TEST(TopologyTest, AllocOnNode) {
+    int node = topology::nodes().front();
+    auto* p = static_cast<char*>(topology::alloc_on_node(10000, node));
+    ASSERT_NE(p, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % 4096, 0);
+    for (size_t i = 0; i < 10000; ++i) p[i] = char(i);
+    for (size_t i = 0; i < 10000; ++i) ASSERT_EQ(p[i], char(i));
+    topology::free_on_node(p, 10000);
+}
+
+TEST(TopologyTest, AllocOnNodeIsBound) {
+    int node = topology::nodes().front();
+    void* p = topology::alloc_on_node(4096, node);
+    ASSERT_NE(p, nullptr);
+    EXPECT_EQ(topology::node_of_address(p), node);
+    topology::free_on_node(p, 4096);
+}
+
+TEST(TopologyTest, AllocOnNodeReportsFailedBinding) {
+    // a node that doesn't exist can't be bound: no silently local memory
+    int missing = topology::nodes().back() + 1;
+    errno = 0;
+    EXPECT_EQ(topology::alloc_on_node(4096, missing), nullptr);
+    EXPECT_NE(errno, 0);
+    EXPECT_THROW(topology::make_on_node<int>(missing, 1), std::system_error);
+}
+
+TEST(TopologyTest, NodePoolReusesBlocks) {
+    int node = topology::nodes().front();
+    auto& pool = topology::NodePool::get(node, 40);
+    EXPECT_EQ(&pool, &topology::NodePool::get(node, 48)); // same rounded block size
+    EXPECT_EQ(pool.block_size(), 48);
+    EXPECT_EQ(pool.node(), node);
+
+    std::vector<void*> blocks;
+    for (int i = 0; i < 1000; ++i) {
+        void* p = pool.allocate();
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % topology::NodePool::BLOCK_ALIGN, 0);
+        std::memset(p, i, 48);
+        blocks.push_back(p);
+    }
+    EXPECT_EQ(topology::node_of_address(blocks.front()), node);
+
+    std::sort(blocks.begin(), blocks.end());
+    EXPECT_EQ(std::adjacent_find(blocks.begin(), blocks.end()), blocks.end()); // no block handed out twice
+
+    for (void* p : blocks) pool.deallocate(p);
+    void* again = pool.allocate();
+    EXPECT_TRUE(std::binary_search(blocks.begin(), blocks.end(), again));
+    pool.deallocate(again);
+}
+
+TEST(TopologyTest, NodePoolAcrossThreads) {
+    auto& pool = topology::NodePool::get(topology::nodes().front(), 32);
+    std::vector<void*> blocks(500);
+    std::thread producer([&]() {
+        for (auto& p : blocks) p = pool.allocate();
+    });
+    producer.join();
+
+    // blocks freed by another thread are reusable
+    for (void* p : blocks) pool.deallocate(p);
+    std::vector<void*> again;
+    for (int i = 0; i < 500; ++i) again.push_back(pool.allocate());
+    for (void* p : again) pool.deallocate(p);
+}
+
+TEST(TopologyTest, NodePoolFreeOnThreadThatNeverAllocated) {
+    // like the rcu reclaimer freeing Stack nodes: the first call into the pool on this
+    // thread is a deallocate
+    auto& pool = topology::NodePool::get(topology::nodes().front(), 48);
+    std::vector<void*> blocks;
+    for (int i = 0; i < 100; ++i) blocks.push_back(pool.allocate());
+
+    std::thread reclaimer([&]() {
+        for (void* p : blocks) pool.deallocate(p);
+    });
+    reclaimer.join();
+
+    // the exiting thread handed its cache back, so those blocks get reused
+    std::vector<void*> again;
+    for (int i = 0; i < 200; ++i) again.push_back(pool.allocate());
+    size_t reused = 0;
+    for (void* p : again) {
+        reused += std::find(blocks.begin(), blocks.end(), p) != blocks.end();
+        pool.deallocate(p);
+    }
+    EXPECT_EQ(reused, blocks.size());
+}
+
+TEST(TopologyTest, MakeOnNode) {
+    struct alignas(64) Padded {
+        int a;
+        explicit Padded(int a): a(a) {}
+    };
+
+    auto p = topology::make_on_node<Padded>(topology::nodes().front(), 7);
+    EXPECT_EQ(p->a, 7);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p.get()) % 64, 0);
+}
+
+TEST(TopologyTest, NodeAllocatorWithVector) {
+    std::vector<int, topology::NodeAllocator<int>> v(topology::NodeAllocator<int>(topology::nodes().front()));
+    for (int i = 0; i < 5000; ++i) v.push_back(i);
+    for (int i = 0; i < 5000; ++i) ASSERT_EQ(v[i], i);
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,355 @@
+/*
+ * This file is part of a project licensed under the GNU General Public License v3.0.
+ *
+ * Copyright (C) 2025 ZHENYU CHEN
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "topology.hpp"
+
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+namespace topology {
+
+namespace {
+
+    const char* NODE_ROOT = "/sys/devices/system/node";
+    const char* CPU_ROOT = "/sys/devices/system/cpu";
+
+    std::string read_line(const std::string& path) {
+        std::ifstream in(path);
+        std::string line;
+        std::getline(in, line);
+        return line;
+    }
+
+    size_t page_size() {
+        static const size_t size = size_t(sysconf(_SC_PAGESIZE));
+        return size;
+    }
+
+    size_t round_to_page(size_t bytes) {
+        auto page = page_size();
+        return (bytes + page - 1) / page * page;
+    }
+
+    // snapshot of the machine, built once on first use
+    struct Topology {
+        std::vector<int> nodes;
+        std::vector<int> cpus;
+        std::vector<std::vector<int>> node_cpus; // indexed by node id
+        std::vector<std::vector<int>> node_distance; // indexed by node id, then node id
+        std::vector<int> cpu_node; // indexed by cpu id, -1 for holes
+
+        Topology() {
+            cpus = parse_cpu_list(read_line(std::string(CPU_ROOT) + "/online"));
+            nodes = parse_cpu_list(read_line(std::string(NODE_ROOT) + "/online"));
+
+            if (nodes.empty()) {
+                // no numa support in this kernel: one node that owns every cpu
+                nodes.push_back(0);
+                node_cpus.push_back(cpus);
+                node_distance.push_back({10});
+            } else {
+                node_cpus.resize(nodes.back() + 1);
+                node_distance.resize(nodes.back() + 1);
+                for (int node : nodes) {
+                    auto dir = std::string(NODE_ROOT) + "/node" + std::to_string(node);
+                    node_cpus[node] = parse_cpu_list(read_line(dir + "/cpulist"));
+
+                    // distance lists one entry per online node, in node order
+                    std::istringstream in(read_line(dir + "/distance"));
+                    node_distance[node].assign(nodes.back() + 1, -1);
+                    for (int other : nodes) {
+                        int d;
+                        if (not (in >> d)) break;
+                        node_distance[node][other] = d;
+                    }
+                }
+            }
+
+            int max_cpu = cpus.empty() ? -1 : cpus.back();
+            for (auto& list : node_cpus) {
+                if (not list.empty()) max_cpu = std::max(max_cpu, list.back());
+            }
+            cpu_node.assign(max_cpu + 1, -1);
+            for (int node : nodes) {
+                for (int cpu : node_cpus[node]) cpu_node[cpu] = node;
+            }
+        }
+    };
+
+    const Topology& topo() {
+        static const Topology instance;
+        return instance;
+    }
+}
+
+std::vector<int> parse_cpu_list(const std::string& list) {
+    std::vector<int> result;
+    std::istringstream in(list);
+    std::string range;
+    while (std::getline(in, range, ',')) {
+        int first, last;
+        char dash;
+        std::istringstream r(range);
+        if (not (r >> first)) continue;
+        if (r >> dash) {
+            if (dash != '-' or not (r >> last) or last < first) continue;
+        } else {
+            last = first;
+        }
+        for (int id = first; id <= last; ++id) result.push_back(id);
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+const std::vector<int>& nodes() {
+    return topo().nodes;
+}
+
+size_t node_count() {
+    return topo().nodes.size();
+}
+
+size_t cpu_count() {
+    return topo().cpus.size();
+}
+
+const std::vector<int>& cpus_of_node(int node) {
+    static const std::vector<int> none;
+    const auto& t = topo();
+    if (node < 0 or size_t(node) >= t.node_cpus.size()) return none;
+    return t.node_cpus[node];
+}
+
+int node_of_cpu(int cpu) {
+    const auto& t = topo();
+    if (cpu < 0 or size_t(cpu) >= t.cpu_node.size()) return -1;
+    return t.cpu_node[cpu];
+}
+
+int distance(int from, int to) {
+    const auto& t = topo();
+    if (from < 0 or size_t(from) >= t.node_distance.size()) return -1;
+    if (to < 0 or size_t(to) >= t.node_distance[from].size()) return -1;
+    return t.node_distance[from][to];
+}
+
+int current_cpu() {
+    return sched_getcpu();
+}
+
+int current_node() {
+    int node = node_of_cpu(current_cpu());
+    return node < 0 ? topo().nodes.front() : node;
+}
+
+bool pin_thread_to_cpu(int cpu) {
+    if (cpu < 0 or cpu >= CPU_SETSIZE) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+bool pin_thread_to_node(int node) {
+    const auto& cpus = cpus_of_node(node);
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    bool any = false;
+    for (int cpu : cpus) {
+        if (cpu >= CPU_SETSIZE) continue;
+        CPU_SET(cpu, &set);
+        any = true;
+    }
+    return any and pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+void* alloc_on_node(size_t bytes, int node) {
+    if (bytes == 0) bytes = 1;
+    auto len = round_to_page(bytes);
+    void* addr = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED) return nullptr;
+
+    if (node >= 0) {
+        constexpr size_t BITS = sizeof(unsigned long) * 8;
+        std::vector<unsigned long> mask(node / BITS + 1, 0);
+        mask[node / BITS] |= 1UL << (node % BITS);
+        // raw syscall so we don't need to link libnuma. Without the binding the first
+        // touch below would place the pages on the caller's node, so report it instead.
+        if (syscall(SYS_mbind, addr, len, MPOL_BIND, mask.data(), mask.size() * BITS + 1, 0) != 0) {
+            int err = errno;
+            munmap(addr, len);
+            errno = err;
+            return nullptr;
+        }
+    }
+
+    // first touch: fault every page in now instead of on the first push
+    auto page = page_size();
+    for (size_t off = 0; off < len; off += page) {
+        static_cast<volatile char*>(addr)[off] = 0;
+    }
+    return addr;
+}
+
+void free_on_node(void* ptr, size_t bytes) noexcept {
+    if (ptr == nullptr) return;
+    munmap(ptr, round_to_page(bytes == 0 ? 1 : bytes));
+}
+
+int node_of_address(const void* addr) {
+    int node = -1;
+    if (syscall(SYS_get_mempolicy, &node, nullptr, 0, addr, MPOL_F_NODE | MPOL_F_ADDR) != 0) return -1;
+    return node;
+}
+
+namespace {
+
+    // bytes carved from alloc_on_node at a time
+    constexpr size_t POOL_CHUNK_SIZE = 64 * 1024;
+    // blocks moved between a thread cache and the shared free list at a time
+    constexpr size_t POOL_BATCH = 32;
+
+}
+
+// per-thread block caches, one entry per pool the thread has used
+struct PoolCaches {
+    struct Entry {
+        NodePool* pool;
+        std::vector<void*> blocks;
+    };
+
+    std::vector<Entry> entries;
+
+    // @return the cache for `pool`, or nullptr if this thread has none yet
+    std::vector<void*>* find(NodePool* pool) noexcept {
+        for (auto& entry : entries) {
+            if (entry.pool == pool) return &entry.blocks;
+        }
+        return nullptr;
+    }
+
+    // @throw std::bad_alloc
+    std::vector<void*>& of(NodePool* pool) {
+        if (auto* blocks = find(pool)) return *blocks;
+        std::vector<void*> blocks;
+        // deallocate never grows past this, so once the entry exists it never allocates
+        blocks.reserve(2 * POOL_BATCH + 1);
+        entries.push_back({pool, std::move(blocks)});
+        return entries.back().blocks;
+    }
+
+    // hand everything back so blocks freed by an exiting thread stay reusable
+    ~PoolCaches() {
+        for (auto& entry : entries) {
+            entry.pool->release(entry.blocks, entry.blocks.size());
+        }
+    }
+};
+
+namespace {
+    thread_local PoolCaches t_pool_caches;
+}
+
+NodePool& NodePool::get(int node, size_t block_size) {
+    static std::mutex mutex;
+    // never destroyed: blocks may be freed by threads exiting after static destruction
+    static auto* pools = new std::map<std::pair<int, size_t>, std::unique_ptr<NodePool>>();
+
+    block_size = (std::max(block_size, size_t(1)) + BLOCK_ALIGN - 1) / BLOCK_ALIGN * BLOCK_ALIGN;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& pool = (*pools)[{node, block_size}];
+    if (pool == nullptr) pool.reset(new NodePool(node, block_size));
+    return *pool;
+}
+
+void* NodePool::allocate() {
+    auto& cache = t_pool_caches.of(this);
+    if (cache.empty()) refill(cache, POOL_BATCH);
+    void* block = cache.back();
+    cache.pop_back();
+    return block;
+}
+
+void NodePool::deallocate(void* block) noexcept {
+    // blocks are often freed by a thread that never allocated from this pool (e.g. the
+    // rcu reclaimer), so creating its cache may fail; the block then goes straight back
+    auto* cache = t_pool_caches.find(this);
+    if (cache == nullptr) {
+        try {
+            cache = &t_pool_caches.of(this);
+        } catch (...) {
+            release_block(block);
+            return;
+        }
+    }
+    cache->push_back(block);
+    if (cache->size() > 2 * POOL_BATCH) release(*cache, POOL_BATCH);
+}
+
+void NodePool::refill(std::vector<void*>& out, size_t count) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    while (count > 0 && not m_free.empty()) {
+        out.push_back(m_free.back());
+        m_free.pop_back();
+        --count;
+    }
+    while (count > 0) {
+        if (m_bump == m_bump_end) {
+            void* chunk = alloc_on_node(POOL_CHUNK_SIZE, m_node);
+            if (chunk == nullptr) throw std::system_error(errno, std::generic_category(), "alloc_on_node");
+            m_bump = static_cast<char*>(chunk);
+            m_bump_end = m_bump + POOL_CHUNK_SIZE / m_block_size * m_block_size;
+        }
+        out.push_back(m_bump);
+        m_bump += m_block_size;
+        --count;
+    }
+}
+
+void NodePool::release(std::vector<void*>& blocks, size_t count) noexcept {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    try {
+        m_free.insert(m_free.end(), blocks.end() - count, blocks.end());
+    } catch (...) {
+        // out of memory for the free list: leak the blocks rather than fail a free
+    }
+    blocks.resize(blocks.size() - count);
+}
+
+void NodePool::release_block(void* block) noexcept {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    try {
+        m_free.push_back(block);
+    } catch (...) {
+        // out of memory for the free list: leak the block rather than fail a free
+    }
+}
+
+}
@@ -0,0 +1,220 @@
+/*
+ * This file is part of a project licensed under the GNU General Public License v3.0.
+ *
+ * Copyright (C) 2025 ZHENYU CHEN
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+// NUMA topology queries, thread pinning and node-bound allocation.
+// Topology is read once from /sys/devices/system/node and /sys/devices/system/cpu.
+// On kernels without NUMA support everything is reported as a single node 0.
+namespace topology {
+
+    // parse a sysfs cpu/node list such as "0-3,8,10-11"
+    // @return the ids in ascending order. Malformed entries are skipped.
+    std::vector<int> parse_cpu_list(const std::string& list);
+
+    // @return ids of all online numa nodes, ascending. Never empty.
+    const std::vector<int>& nodes();
+
+    // @return number of online numa nodes. Always >= 1.
+    size_t node_count();
+
+    // @return number of online cpus.
+    size_t cpu_count();
+
+    // @return online cpus belonging to `node`, empty if the node is unknown.
+    const std::vector<int>& cpus_of_node(int node);
+
+    // @return node of `cpu`, or -1 if the cpu is unknown.
+    int node_of_cpu(int cpu);
+
+    // @return SLIT distance between two nodes as reported by the kernel (10 == local),
+    //         or -1 if unknown.
+    int distance(int from, int to);
+
+    // @return the cpu the calling thread is running on right now.
+    // @note the thread may be migrated right after the call unless it is pinned.
+    int current_cpu();
+
+    // @return the node the calling thread is running on right now. Falls back to the
+    //         first online node if it cannot be determined.
+    int current_node();
+
+    // restrict the calling thread to a single cpu.
+    // @return false if the kernel rejected the affinity mask.
+    bool pin_thread_to_cpu(int cpu);
+
+    // restrict the calling thread to all cpus of `node`.
+    // @return false if the node has no cpus or the kernel rejected the mask.
+    bool pin_thread_to_node(int node);
+
+    /**
+     * allocate `bytes` of page-aligned memory whose pages live on `node`.
+     * The range is bound with mbind(MPOL_BIND) and then first-touched, so no page
+     * fault is left for the hot path.
+     * @return nullptr with errno set if the mapping cannot be created or the kernel
+     *         refuses the binding (e.g. mbind blocked by a container's seccomp profile)
+     * @note granularity is a page, so this is meant for bulk storage. Small objects
+     *       should come from a NodePool.
+     */
+    void* alloc_on_node(size_t bytes, int node);
+
+    // release memory obtained from alloc_on_node. `bytes` must match the allocation.
+    void free_on_node(void* ptr, size_t bytes) noexcept;
+
+    // @return the node the page holding `addr` currently lives on, or -1 if unknown
+    //         (e.g. the page was never touched or get_mempolicy is not permitted).
+    int node_of_address(const void* addr);
+
+    /**
+     * fixed-size block pool whose memory is bound to one node.
+     * Blocks are carved from node-bound chunks, so an allocation is a free-list pop
+     * instead of an mmap. Every thread keeps a small cache per pool and only touches the
+     * shared free list, under a mutex, in batches.
+     * @note pools are process-wide, one per (node, block size), and keep their chunks
+     *       for the lifetime of the process.
+     */
+    class NodePool {
+    public:
+        static constexpr size_t MAX_BLOCK_SIZE = 256;
+        static constexpr size_t BLOCK_ALIGN = 16;
+
+        // @return the pool for `node` whose blocks fit `block_size` bytes
+        static NodePool& get(int node, size_t block_size);
+
+        // @throw std::system_error if a new chunk cannot be bound to the node
+        void* allocate();
+        void deallocate(void* block) noexcept;
+
+        int node() const noexcept { return m_node; }
+        size_t block_size() const noexcept { return m_block_size; }
+
+    private:
+        NodePool(int node, size_t block_size): m_node(node), m_block_size(block_size) {}
+
+        // move up to `count` blocks from the shared free list (or a fresh chunk) into `out`
+        void refill(std::vector<void*>& out, size_t count);
+        // move the last `count` blocks of `blocks` back to the shared free list
+        void release(std::vector<void*>& blocks, size_t count) noexcept;
+        // put a single block back on the shared free list
+        void release_block(void* block) noexcept;
+
+        friend struct PoolCaches;
+
+        int m_node;
+        size_t m_block_size;
+
+        std::mutex m_mutex; // guards everything below
+        std::vector<void*> m_free;
+        char* m_bump = nullptr;
+        char* m_bump_end = nullptr;
+    };
+
+    /**
+     * std-compatible allocator handing out node-bound memory.
+     * Single small objects (e.g. Stack nodes) come from the node's NodePool, anything
+     * else from alloc_on_node.
+     * @throw std::system_error if the memory cannot be bound to the node
+     */
+    template <typename T>
+    struct NodeAllocator {
+        using value_type = T;
+
+        int node;
+
+        explicit NodeAllocator(int node) noexcept: node(node) {}
+
+        template <typename U>
+        NodeAllocator(const NodeAllocator<U>& other) noexcept: node(other.node) {}
+
+        T* allocate(size_t n) {
+            if (pooled(n)) return static_cast<T*>(pool().allocate());
+
+            void* p = alloc_on_node(n * sizeof(T), node);
+            if (p == nullptr) throw std::system_error(errno, std::generic_category(), "alloc_on_node");
+            return static_cast<T*>(p);
+        }
+
+        void deallocate(T* p, size_t n) noexcept {
+            if (pooled(n)) {
+                pool().deallocate(p);
+            } else {
+                free_on_node(p, n * sizeof(T));
+            }
+        }
+
+        template <typename U>
+        bool operator==(const NodeAllocator<U>& other) const noexcept { return node == other.node; }
+
+    private:
+        static constexpr bool SMALL = sizeof(T) <= NodePool::MAX_BLOCK_SIZE && alignof(T) <= NodePool::BLOCK_ALIGN;
+
+        static bool pooled(size_t n) noexcept {
+            return SMALL && n == 1;
+        }
+
+        // NodePool::get takes a lock, so remember the last pool this thread used
+        NodePool& pool() const {
+            thread_local NodePool* cached = nullptr;
+            if (cached == nullptr || cached->node() != node) {
+                cached = &NodePool::get(node, sizeof(T));
+            }
+            return *cached;
+        }
+    };
+
+    // deleter for objects created by make_on_node
+    template <typename T>
+    struct NodeDeleter {
+        void operator()(T* p) const noexcept {
+            p->~T();
+            free_on_node(p, sizeof(T));
+        }
+    };
+
+    template <typename T>
+    using node_unique_ptr = std::unique_ptr<T, NodeDeleter<T>>;
+
+    /**
+     * construct a T in memory bound to `node`.
+     * This is how a RingBuffer or Stack (including its inline storage and indices)
+     * gets placed on the socket of the threads that use it.
+     * @throw std::system_error if the memory cannot be bound to the node
+     */
+    template <typename T, typename... Args>
+    node_unique_ptr<T> make_on_node(int node, Args&&... args) {
+        void* p = alloc_on_node(sizeof(T), node);
+        if (p == nullptr) throw std::system_error(errno, std::generic_category(), "alloc_on_node");
+        try {
+            return node_unique_ptr<T>(new (p) T(std::forward<Args>(args)...));
+        } catch (...) {
+            free_on_node(p, sizeof(T));
+            throw;
+        }
+    }
+}
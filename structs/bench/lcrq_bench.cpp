@@ -0,0 +1,58 @@
+/*
+ * This file is part of a project licensed under the GNU General Public License v3.0.
+ *
+ * Copyright (C) 2025 ZHENYU CHEN
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Fan-in throughput of LCRQ against the CAS-loop Michael-Scott queue: every thread
+// pushes one item and pops one item per iteration, from 1 up to 64 threads. Both queues
+// reclaim through the same rcu, so the gap is fetch_add cells vs retried CAS on head and
+// tail. The Treiber Stack is kept as a second CAS-loop reference.
+
+#include <benchmark/benchmark.h>
+
+#include "lcrq.h"
+#include "ms_queue.h"
+#include "treiber_stack.h"
+
+#include <cstdint>
+
+namespace {
+
+    template <typename Queue>
+    Queue* g_queue = nullptr;
+
+    template <typename Queue>
+    void BM_PushPop(benchmark::State& state) {
+        if (state.thread_index() == 0) g_queue<Queue> = new Queue();
+        uint64_t val = 0;
+        for (auto _ : state) {
+            g_queue<Queue>->push(val);
+            while (not g_queue<Queue>->try_pop(val));
+        }
+        state.SetItemsProcessed(state.iterations());
+        if (state.thread_index() == 0) {
+            delete g_queue<Queue>;
+            g_queue<Queue> = nullptr;
+        }
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_PushPop, LCRQ<uint64_t>)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_PushPop, MSQueue<uint64_t>)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_PushPop, Stack<uint64_t>)->ThreadRange(1, 64)->UseRealTime();
+
+BENCHMARK_MAIN();
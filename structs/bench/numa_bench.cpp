@@ -0,0 +1,163 @@
+/*
+ * This file is part of a project licensed under the GNU General Public License v3.0.
+ *
+ * Copyright (C) 2025 ZHENYU CHEN
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Cross-thread handoff cost for RingBuffer, a node-bound Stack and CohortStack depending
+// on where the two threads and the structure's memory live:
+//   same_node:     producer, consumer and memory on one node
+//   cross_node:    consumer on another node than producer and memory
+//   remote_memory: both threads on one node, memory on another
+// CohortStack binds each cohort to its own node, so it only has the first two.
+// Configurations the machine cannot express are reported and skipped, and so is any run
+// whose memory did not actually end up on the requested node.
+
+#include <benchmark/benchmark.h>
+
+#include "cohort_stack.h"
+#include "spsc.h"
+#include "treiber_stack.h"
+#include "topology.hpp"
+
+#include <iostream>
+#include <string>
+#include <system_error>
+#include <thread>
+
+namespace {
+
+    struct Placement {
+        std::string name;
+        int producer_cpu;
+        int consumer_cpu;
+        int memory_node; // -1: the structure places itself
+    };
+
+    using BoundStack = Stack<int, topology::NodeAllocator<int>>;
+
+    // @return an error message if `addr` is not on `node`, empty otherwise
+    std::string check_placement(const void* addr, int node, const char* what) {
+        int actual = topology::node_of_address(addr);
+        if (actual == node) return {};
+        return std::string(what) + " is on node " + std::to_string(actual)
+            + ", expected node " + std::to_string(node);
+    }
+
+    template <typename Queue, typename Make, typename Check, typename Push, typename Pop>
+    void run_handoff(benchmark::State& state, const Placement& placement, Make make, Check check, Push push, Pop pop) {
+        topology::pin_thread_to_cpu(placement.producer_cpu);
+
+        topology::node_unique_ptr<Queue> queue;
+        try {
+            queue = make();
+            // one handoff up front, so a node pool that can't bind a chunk fails here
+            push(*queue, 0);
+            pop(*queue);
+        } catch (const std::system_error& e) {
+            state.SkipWithError(e.what());
+            return;
+        }
+
+        auto error = check(*queue);
+        if (not error.empty()) {
+            state.SkipWithError(error.c_str());
+            return;
+        }
+
+        std::thread consumer([&]() {
+            topology::pin_thread_to_cpu(placement.consumer_cpu);
+            while (pop(*queue) >= 0);
+        });
+
+        int64_t items = 0;
+        for (auto _ : state) {
+            push(*queue, 1);
+            ++items;
+        }
+        push(*queue, -1); // stop the consumer
+        consumer.join();
+
+        state.SetItemsProcessed(items);
+    }
+
+    void ring_buffer_handoff(benchmark::State& state, Placement placement) {
+        using Queue = RingBuffer<int, 1024>;
+        run_handoff<Queue>(state, placement,
+            [&]() { return topology::make_on_node<Queue>(placement.memory_node); },
+            [&](Queue& q) { return check_placement(&q, placement.memory_node, "ring buffer"); },
+            [](auto& q, int v) { q.push(v); },
+            [](auto& q) { return q.pop(); });
+    }
+
+    void stack_handoff(benchmark::State& state, Placement placement) {
+        run_handoff<BoundStack>(state, placement,
+            [&]() {
+                return topology::make_on_node<BoundStack>(placement.memory_node, topology::NodeAllocator<int>(placement.memory_node));
+            },
+            // nodes come from a NodePool, which fails hard if its chunks can't be bound
+            [&](BoundStack& q) { return check_placement(&q, placement.memory_node, "stack"); },
+            [](auto& q, int v) { q.push(v); },
+            [](auto& q) { return q.pop(); });
+    }
+
+    void cohort_stack_handoff(benchmark::State& state, Placement placement) {
+        using Queue = CohortStack<int>;
+        run_handoff<Queue>(state, placement,
+            [&]() { return topology::make_on_node<Queue>(topology::node_of_cpu(placement.producer_cpu)); },
+            [&](Queue&) { return std::string(); }, // each cohort is bound by CohortStack itself
+            [](auto& q, int v) { q.push(v); },
+            [](auto& q) { return q.pop(); });
+    }
+
+    std::vector<Placement> placements() {
+        std::vector<Placement> result;
+        const auto& nodes = topology::nodes();
+        const auto& local = topology::cpus_of_node(nodes[0]);
+
+        if (local.size() >= 2) {
+            result.push_back({"same_node", local[0], local[1], nodes[0]});
+        } else {
+            std::cerr << "skipping same_node: node " << nodes[0] << " has fewer than 2 cpus\n";
+        }
+
+        if (nodes.size() >= 2 and not topology::cpus_of_node(nodes[1]).empty() and not local.empty()) {
+            const auto& remote = topology::cpus_of_node(nodes[1]);
+            result.push_back({"cross_node", local[0], remote[0], nodes[0]});
+            if (local.size() >= 2) {
+                result.push_back({"remote_memory", local[0], local[1], nodes[1]});
+            }
+        } else {
+            std::cerr << "skipping cross_node and remote_memory: only one numa node with cpus\n";
+        }
+        return result;
+    }
+}
+
+int main(int argc, char** argv) {
+    for (const auto& placement : placements()) {
+        benchmark::RegisterBenchmark(("RingBuffer/" + placement.name).c_str(), ring_buffer_handoff, placement)->UseRealTime();
+        benchmark::RegisterBenchmark(("NodeBoundStack/" + placement.name).c_str(), stack_handoff, placement)->UseRealTime();
+        if (placement.name != "remote_memory") {
+            benchmark::RegisterBenchmark(("CohortStack/" + placement.name).c_str(), cohort_stack_handoff, placement)->UseRealTime();
+        }
+    }
+
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
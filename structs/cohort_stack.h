@@ -0,0 +1,122 @@
+/*
+ * This file is part of a project licensed under the GNU General Public License v3.0.
+ *
+ * Copyright (C) 2025 ZHENYU CHEN
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "treiber_stack.h"
+#include "topology.hpp"
+
+#include <algorithm>
+#include <vector>
+
+/** hierarchical (cohort-style) stack.
+ * One Stack per numa node. Both the stack and its nodes live in memory bound to that
+ * node. push goes to the caller's node, pop drains the caller's node first and only then
+ * steals from the other nodes, nearest (by SLIT distance) first. So as long as there is local work, items are
+ * handed off inside a socket and the top pointer never bounces across the interconnect.
+ * @note there is no global LIFO order, only per-node LIFO order.
+ * @note nodes are reclaimed through rcu, like Stack.
+ */
+template <typename T>
+class CohortStack
+{
+private:
+    using LocalAlloc = topology::NodeAllocator<T>;
+    using LocalStack = Stack<T, LocalAlloc>;
+
+    std::vector<int> m_nodes; // online node ids, index i owns m_stacks[i]
+    std::vector<topology::node_unique_ptr<LocalStack>> m_stacks;
+    std::vector<std::vector<size_t>> m_stealOrder; // per index: other indices, nearest first
+
+    // @return the index of the caller's node in m_nodes
+    size_t localIndex() const
+    {
+        if (m_nodes.size() == 1) return 0;
+        auto it = std::find(m_nodes.begin(), m_nodes.end(), topology::current_node());
+        return it == m_nodes.end() ? 0 : size_t(it - m_nodes.begin());
+    }
+
+public:
+    CohortStack(): m_nodes(topology::nodes())
+    {
+        for (int node : m_nodes)
+        {
+            m_stacks.push_back(topology::make_on_node<LocalStack>(node, LocalAlloc(node)));
+        }
+
+        m_stealOrder.resize(m_nodes.size());
+        for (size_t i = 0; i < m_nodes.size(); ++i)
+        {
+            for (size_t j = 0; j < m_nodes.size(); ++j)
+            {
+                if (j != i) m_stealOrder[i].push_back(j);
+            }
+            std::stable_sort(m_stealOrder[i].begin(), m_stealOrder[i].end(), [&](size_t a, size_t b) {
+                return topology::distance(m_nodes[i], m_nodes[a]) < topology::distance(m_nodes[i], m_nodes[b]);
+            });
+        }
+    }
+
+    // @return number of per-node stacks
+    size_t cohorts() const
+    {
+        return m_stacks.size();
+    }
+
+    bool empty()
+    {
+        for (auto& stack : m_stacks)
+        {
+            if (not stack->empty()) return false;
+        }
+        return true;
+    }
+
+    void push(const T& val)
+    {
+        m_stacks[localIndex()]->push(val);
+    }
+
+    // push to a specific cohort, mostly useful for tests and benchmarks
+    void push_to(size_t cohort, const T& val)
+    {
+        m_stacks[cohort]->push(val);
+    }
+
+    // non-blocking pop: local cohort first, then the others by distance
+    // @return false if every cohort was empty when visited
+    bool try_pop(T& val)
+    {
+        auto local = localIndex();
+        if (m_stacks[local]->try_pop(val)) return true;
+        for (auto other : m_stealOrder[local])
+        {
+            if (m_stacks[other]->try_pop(val)) return true;
+        }
+        return false;
+    }
+
+    // blocking pop
+    T pop()
+    {
+        T val;
+        while (not try_pop(val));
+        return val;
+    }
+};
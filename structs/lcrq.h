@@ -0,0 +1,323 @@
+/*
+ * This file is part of a project licensed under the GNU General Public License v3.0.
+ *
+ * Copyright (C) 2025 ZHENYU CHEN
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "atomic.hpp"
+#include "rcu.hpp"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// can use std::hardware_destructive_interference_size in #include<new> if it is supported
+#define LCRQ_CACHE_LINE_SIZE 64
+
+/** unbounded lock-free mpmc queue (LCRQ, Morrison & Afek, PPoPP'13).
+ *
+ * The queue is a linked list of CRQs (concurrent ring queues). Inside a CRQ, head and
+ * tail are plain counters advanced with fetch_add, so every operation gets its own
+ * cell instead of fighting over a single CAS target. Each cell is a 16-byte
+ * (flags|index, value) pair updated with cmpxchg16b. When a CRQ fills up or an
+ * enqueuer starves, the CRQ is closed and a fresh one is appended.
+ *
+ * Drained CRQs are unlinked from the list and freed through call_rcu. Every operation
+ * runs inside an rcu read-side section, so a CRQ is never freed while a thread can
+ * still reach it.
+ *
+ * @tparam T: trivially copyable, at most 8 bytes. Store pointers for anything bigger.
+ * @tparam RING_SIZE: cells per CRQ, power of two.
+ */
+template <typename T, size_t RING_SIZE = 4096>
+    requires (std::is_trivially_copyable_v<T> && sizeof(T) <= sizeof(uint64_t)
+              && RING_SIZE > 1 && (RING_SIZE & (RING_SIZE - 1)) == 0)
+class LCRQ
+{
+private:
+    // cell index word layout: [63 unsafe][62 full][61..0 index]
+    static constexpr uint64_t UNSAFE = 1ULL << 63;
+    static constexpr uint64_t FULL = 1ULL << 62;
+    static constexpr uint64_t INDEX_MASK = FULL - 1;
+
+    // tail counter bit set once a CRQ is closed for enqueues
+    static constexpr uint64_t CLOSED = 1ULL << 63;
+
+    // failed enqueue attempts on one CRQ before giving up on it and closing it
+    static constexpr int STARVATION_LIMIT = 16;
+
+    struct alignas(16) Cell
+    {
+        std::atomic<uint64_t> index; // lower half of the cmpxchg16b word
+        std::atomic<uint64_t> value; // upper half
+    };
+
+    static bool cas2(Cell& cell, uint64_t index, uint64_t value, uint64_t newIndex, uint64_t newValue)
+    {
+        uint128_t expected(index, value);
+        return cmpxchg16b(reinterpret_cast<uint128_t*>(&cell), expected, uint128_t(newIndex, newValue));
+    }
+
+    struct CRQ
+    {
+        alignas(LCRQ_CACHE_LINE_SIZE) std::atomic<uint64_t> head {0};
+        alignas(LCRQ_CACHE_LINE_SIZE) std::atomic<uint64_t> tail {0};
+        alignas(LCRQ_CACHE_LINE_SIZE) std::atomic<CRQ*> next {nullptr};
+        alignas(LCRQ_CACHE_LINE_SIZE) std::array<Cell, RING_SIZE> ring;
+
+        CRQ()
+        {
+            for (size_t i = 0; i < RING_SIZE; ++i)
+            {
+                ring[i].index.store(i, std::memory_order_relaxed);
+                ring[i].value.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        // a CRQ that already holds `first`, used when appending to a closed CRQ
+        explicit CRQ(uint64_t first): CRQ()
+        {
+            ring[0].index.store(FULL | 0, std::memory_order_relaxed);
+            ring[0].value.store(first, std::memory_order_relaxed);
+            tail.store(1, std::memory_order_relaxed);
+        }
+
+        // @return false if the CRQ is closed; the item was not enqueued
+        bool enqueue(uint64_t item)
+        {
+            for (int tries = 0; ; ++tries)
+            {
+                auto t = tail.fetch_add(1);
+                if (t & CLOSED) return false;
+
+                auto& cell = ring[t & (RING_SIZE - 1)];
+                auto index = cell.index.load(std::memory_order_acquire);
+                auto value = cell.value.load(std::memory_order_acquire);
+
+                // the cell is ours if it is empty, not from a later round, and either safe
+                // or no dequeuer has passed it yet
+                if (not (index & FULL) && (index & INDEX_MASK) <= t
+                    && (not (index & UNSAFE) || head.load() <= t))
+                {
+                    if (cas2(cell, index, value, FULL | t, item)) return true;
+                }
+
+                auto h = head.load();
+                if (int64_t(t - h) >= int64_t(RING_SIZE) || tries >= STARVATION_LIMIT)
+                {
+                    tail.fetch_or(CLOSED);
+                    return false;
+                }
+            }
+        }
+
+        // @return false if the CRQ was empty
+        bool dequeue(uint64_t& item)
+        {
+            while (true)
+            {
+                auto h = head.fetch_add(1);
+                auto& cell = ring[h & (RING_SIZE - 1)];
+
+                while (true)
+                {
+                    auto index = cell.index.load(std::memory_order_acquire);
+                    auto value = cell.value.load(std::memory_order_acquire);
+                    auto unsafe = index & UNSAFE;
+                    auto idx = index & INDEX_MASK;
+
+                    if (idx > h) break; // already moved on to a later round
+
+                    if (index & FULL)
+                    {
+                        if (idx == h)
+                        {
+                            // our item: take it and advance the cell to the next round
+                            if (cas2(cell, index, value, unsafe | (h + RING_SIZE), 0))
+                            {
+                                item = value;
+                                return true;
+                            }
+                        }
+                        else
+                        {
+                            // an item from an earlier round that its dequeuer hasn't taken
+                            // yet: mark the cell unsafe so no enqueuer of round h reuses it
+                            if (cas2(cell, index, value, index | UNSAFE, value)) break;
+                        }
+                    }
+                    else
+                    {
+                        // empty: advance the cell so the enqueuer of round h fails on it
+                        if (cas2(cell, index, value, unsafe | (h + RING_SIZE), value)) break;
+                    }
+                }
+
+                auto t = tail.load() & ~CLOSED;
+                if (t <= h + 1)
+                {
+                    fixState();
+                    return false;
+                }
+            }
+        }
+
+        // dequeuers may push head past tail; pull tail back up so enqueuers don't
+        // land on cells that were already advanced
+        void fixState()
+        {
+            while (true)
+            {
+                auto t = tail.load();
+                auto h = head.load();
+                if (tail.load() != t) continue;
+                if (h <= t) return; // also true once closed
+                if (tail.compare_exchange_strong(t, h)) return;
+            }
+        }
+    };
+
+    alignas(LCRQ_CACHE_LINE_SIZE) std::atomic<CRQ*> m_head;
+    alignas(LCRQ_CACHE_LINE_SIZE) std::atomic<CRQ*> m_tail;
+
+    static uint64_t toBits(const T& val)
+    {
+        uint64_t bits = 0;
+        std::memcpy(&bits, &val, sizeof(T));
+        return bits;
+    }
+
+    // goes through a byte array so T needs no default constructor
+    static T fromBits(uint64_t bits)
+    {
+        std::array<unsigned char, sizeof(T)> bytes;
+        std::memcpy(bytes.data(), &bits, sizeof(T));
+        return std::bit_cast<T>(bytes);
+    }
+
+    // @return false if the queue was empty at the time of the attempt
+    bool tryDequeue(uint64_t& item)
+    {
+        rcu_read_guard guard;
+        while (true)
+        {
+            auto* crq = m_head.load(std::memory_order_acquire);
+            if (crq->dequeue(item)) return true;
+
+            auto* next = crq->next.load(std::memory_order_acquire);
+            if (next == nullptr) return false;
+
+            // the CRQ is closed; an enqueue may have landed between our two looks
+            if (crq->dequeue(item)) return true;
+
+            // unlink the drained CRQ. Tail must not point at it either, or a new
+            // reader could still reach it after the grace period.
+            auto* tail = crq;
+            m_tail.compare_exchange_strong(tail, next);
+            if (m_head.compare_exchange_strong(crq, next))
+            {
+                call_rcu([crq]() { delete crq; });
+            }
+        }
+    }
+
+public:
+    LCRQ()
+    {
+        auto* crq = new CRQ();
+        m_head.store(crq, std::memory_order_relaxed);
+        m_tail.store(crq, std::memory_order_relaxed);
+    }
+
+    LCRQ(const LCRQ&) = delete;
+    LCRQ& operator=(const LCRQ&) = delete;
+
+    ~LCRQ()
+    {
+        // destructor should be only called once, and only when no thread is using the queue!
+        auto* crq = m_head.load(std::memory_order_relaxed);
+        while (crq != nullptr)
+        {
+            auto* next = crq->next.load(std::memory_order_relaxed);
+            delete crq;
+            crq = next;
+        }
+    }
+
+    // @return if the queue is empty at a serilization point.
+    bool empty()
+    {
+        rcu_read_guard guard;
+        auto* crq = m_head.load(std::memory_order_acquire);
+        return crq->next.load(std::memory_order_acquire) == nullptr
+            && crq->head.load() >= (crq->tail.load() & ~CLOSED);
+    }
+
+    /**
+     * push an element to the queue
+     * @note never blocks: a full or contended ring is closed and a new one appended
+     */
+    void push(const T& val)
+    {
+        auto item = toBits(val);
+        rcu_read_guard guard;
+        while (true)
+        {
+            auto* crq = m_tail.load(std::memory_order_acquire);
+            auto* next = crq->next.load(std::memory_order_acquire);
+            if (next != nullptr)
+            {
+                // help a slow appender swing the tail
+                m_tail.compare_exchange_strong(crq, next);
+                continue;
+            }
+
+            if (crq->enqueue(item)) return;
+
+            auto* fresh = new CRQ(item);
+            CRQ* expected = nullptr;
+            if (crq->next.compare_exchange_strong(expected, fresh))
+            {
+                m_tail.compare_exchange_strong(crq, fresh);
+                return;
+            }
+            delete fresh; // never published
+        }
+    }
+
+    // non-blocking pop
+    // @return false if the queue was empty at the time of the attempt
+    bool try_pop(T& val)
+    {
+        uint64_t item;
+        if (not tryDequeue(item)) return false;
+        val = fromBits(item);
+        return true;
+    }
+
+    // blocking pop
+    T pop()
+    {
+        uint64_t item;
+        while (not tryDequeue(item));
+        return fromBits(item);
+    }
+};
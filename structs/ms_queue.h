@@ -0,0 +1,155 @@
+/*
+ * This file is part of a project licensed under the GNU General Public License v3.0.
+ *
+ * Copyright (C) 2025 ZHENYU CHEN
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "rcu.hpp"
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+// can use std::hardware_destructive_interference_size in #include<new> if it is supported
+#define MS_QUEUE_CACHE_LINE_SIZE 64
+
+/** unbounded lock-free mpmc queue (Michael & Scott, PODC'96).
+ *
+ * A singly linked list with a dummy head node. Enqueuers CAS the last node's next
+ * pointer and then swing the tail, dequeuers CAS the head forward; every thread retries
+ * on the same two words, which is the CAS-loop design LCRQ is measured against.
+ *
+ * Dequeued dummies are freed through call_rcu and every operation runs inside an rcu
+ * read-side section, so a node is never freed (or reused, which rules out ABA) while a
+ * thread can still reach it.
+ */
+template <typename T>
+class MSQueue
+{
+private:
+    struct Node
+    {
+        // live from push until the pop that makes this node the new dummy
+        union { T val; };
+        std::atomic<Node*> next;
+
+        Node(): next(nullptr) {}
+        explicit Node(const T& val): val(val), next(nullptr) {}
+        ~Node() {}
+    };
+
+    alignas(MS_QUEUE_CACHE_LINE_SIZE) std::atomic<Node*> m_head;
+    alignas(MS_QUEUE_CACHE_LINE_SIZE) std::atomic<Node*> m_tail;
+
+    // unlink the first element and hand its value to `take`
+    // @return false if the queue was empty at the time of the attempt
+    template <typename Take>
+    bool tryDequeue(Take&& take)
+    {
+        rcu_read_guard guard;
+        while (true)
+        {
+            auto* head = m_head.load(std::memory_order_acquire);
+            auto* next = head->next.load(std::memory_order_acquire);
+            if (next == nullptr) return false;
+
+            // tail must never fall behind head, or an enqueuer could link onto a freed node
+            auto* tail = head;
+            m_tail.compare_exchange_strong(tail, next);
+
+            if (m_head.compare_exchange_strong(head, next))
+            {
+                // `next` is the new dummy; only the winner of this CAS touches its value
+                take(next->val);
+                next->val.~T();
+                call_rcu([head]() { delete head; });
+                return true;
+            }
+        }
+    }
+
+public:
+    MSQueue()
+    {
+        auto* dummy = new Node();
+        m_head.store(dummy, std::memory_order_relaxed);
+        m_tail.store(dummy, std::memory_order_relaxed);
+    }
+
+    MSQueue(const MSQueue&) = delete;
+    MSQueue& operator=(const MSQueue&) = delete;
+
+    ~MSQueue()
+    {
+        // destructor should be only called once, and only when no thread is using the queue!
+        auto* node = m_head.load(std::memory_order_relaxed);
+        auto* next = node->next.load(std::memory_order_relaxed);
+        delete node; // the dummy holds no value
+        for (node = next; node != nullptr; node = next)
+        {
+            next = node->next.load(std::memory_order_relaxed);
+            node->val.~T();
+            delete node;
+        }
+    }
+
+    // @return if the queue is empty at a serilization point.
+    bool empty()
+    {
+        rcu_read_guard guard;
+        return m_head.load(std::memory_order_acquire)->next.load(std::memory_order_acquire) == nullptr;
+    }
+
+    void push(const T& val)
+    {
+        auto* node = new Node(val);
+        rcu_read_guard guard;
+        while (true)
+        {
+            auto* tail = m_tail.load(std::memory_order_acquire);
+            auto* next = tail->next.load(std::memory_order_acquire);
+            if (next != nullptr)
+            {
+                // help a slow enqueuer swing the tail
+                m_tail.compare_exchange_strong(tail, next);
+                continue;
+            }
+
+            if (tail->next.compare_exchange_strong(next, node))
+            {
+                m_tail.compare_exchange_strong(tail, node);
+                return;
+            }
+        }
+    }
+
+    // non-blocking pop
+    // @return false if the queue was empty at the time of the attempt
+    bool try_pop(T& val)
+    {
+        return tryDequeue([&](T& front) { val = std::move(front); });
+    }
+
+    // blocking pop
+    T pop()
+    {
+        std::optional<T> val;
+        while (not tryDequeue([&](T& front) { val.emplace(std::move(front)); }));
+        return std::move(*val);
+    }
+};
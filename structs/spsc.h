@@ -17,28 +17,42 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#pragma once
+
 #include <atomic>
 #include <cstdint>
 #include <cstddef>
 #include <array>
+#include <memory>
+#include <new>
+#include <type_traits>
 #include <utility>
 
 // can use std::hardware_destructive_interference_size in #include<new> if it is supported
 #define CACHE_LINE_SIZE 64
 
 /** this is a spsc ring buffer, with a fixed size.
- * @tparam T: must be default constructable
+ * @tparam T: any move constructible type. Slots are raw storage, so T need not be default
+ *            constructible, and an element only exists between its push and its pop.
  * @tparam N: size of the ring buffer. Actual capacity would be N - 1 as we'd like to reserve one slot
  * we're using two atomic variable to manage the states of this ring buffer.
  * @note m_start is able to be larger then m_end (as it is ring buffer)
  * @note we'd like to reserve one slot, to differenciate if the queue is empty or full. 
  *       if the size is already N-1, we'd consider it's full.
+ * @note for trivially copyable T construction and destruction compile down to plain copies.
 */
 template <typename T, size_t N>
-    requires requires {std::is_default_constructible_v<T> && N > 1;}
+    requires (N > 1 && std::is_move_constructible_v<T>)
 struct RingBuffer{
 private:
-    std::array<T, N> m_arr;
+    static constexpr bool TRIVIAL = std::is_trivially_copyable_v<T>;
+
+    // uninitialized storage for one element
+    struct Slot {
+        alignas(T) unsigned char bytes[sizeof(T)];
+    };
+
+    std::array<Slot, N> m_arr;
 
     alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_end {0}; // next slot to push. Update by the writer thread.
     alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_start {0}; // next slot to pop. Updated by the reader thread.
@@ -55,10 +69,60 @@ private:
         return ret;
     }
 
+    // @return the live element in slot `idx`
+    T* at(size_t idx) {
+        return std::launder(reinterpret_cast<T*>(m_arr[idx].bytes));
+    }
+
+    template <typename... Args>
+    void construct(size_t idx, Args&&... args) {
+        ::new (static_cast<void*>(m_arr[idx].bytes)) T(std::forward<Args>(args)...);
+    }
+
+    void destroy(size_t idx) {
+        if constexpr (not std::is_trivially_destructible_v<T>) {
+            std::destroy_at(at(idx));
+        }
+    }
+
+    // move the element out of slot `idx` and end its lifetime
+    T take(size_t idx) {
+        if constexpr (TRIVIAL) {
+            return *at(idx);
+        } else {
+            T val = std::move(*at(idx));
+            destroy(idx);
+            return val;
+        }
+    }
+
+    // spin until there is a free slot
+    // @return the slot to write
+    size_t wait_for_slot() {
+        size_t to_write;
+        do {
+            to_write = m_end.load(std::memory_order_relaxed);
+        } while (next(to_write) == m_start.load(std::memory_order_acquire));
+        return to_write;
+    }
+
 public:
 
     RingBuffer(): m_end(0), m_start(0) {}
 
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+
+    // destroys the elements still in the queue. No thread may be using it.
+    ~RingBuffer() {
+        if constexpr (not std::is_trivially_destructible_v<T>) {
+            auto end = m_end.load(std::memory_order_acquire);
+            for (auto idx = m_start.load(std::memory_order_relaxed); idx != end; idx = next(idx)) {
+                destroy(idx);
+            }
+        }
+    }
+
     // @return if the queue is empty.
     // @note this is if a queue is empty at a serilization point.
     //       doesn't necessarlily mean it is still empty when reading the result
@@ -75,24 +139,36 @@ public:
     }
 
     /**
-     * Push an element to the queue
-     * @param val: the value to be pushed
+     * construct an element in place at the back of the queue
+     * @param args: forwarded to the constructor of T
      * @note this function will block until there's a slot being able to use
+     * @note if the constructor throws, the queue is left unchanged
      */
-    void push(T val) {
-        size_t to_write;
-        do {
-            to_write = m_end.load(std::memory_order_relaxed);
-        } while (next(to_write) == m_start.load(std::memory_order_acquire));
+    template <typename... Args>
+    void emplace(Args&&... args) {
+        auto to_write = wait_for_slot();
         // now we have at least one slot to use
 
-        m_arr[to_write] = val;
+        construct(to_write, std::forward<Args>(args)...);
         m_end.store(next(to_write), std::memory_order::release);
     }
 
+    /**
+     * Push an element to the queue
+     * @param val: the value to be pushed
+     * @note this function will block until there's a slot being able to use
+     */
+    void push(const T& val) {
+        emplace(val);
+    }
+
+    void push(T&& val) {
+        emplace(std::move(val));
+    }
+
     /**
      * pop an elemet out of the queue
-     * @return the value to be poped
+     * @return the value to be poped, moved out of its slot. The slot is destroyed.
      * @note this function will block until there's a slot to pop
      */
     T pop() {
@@ -103,7 +179,7 @@ public:
 
         // now we have at least one slot to use
 
-        auto val = std::move(m_arr[to_pop]);
+        auto val = take(to_pop);
         m_start.store(next(to_pop), std::memory_order::release);
 
         return val;
@@ -127,23 +203,34 @@ public:
         return N - 1;
     }
 
-    bool try_push(const T& val) {
+    // non-blocking emplace
+    // @return false (and constructs nothing) if the queue is full
+    template <typename... Args>
+    bool try_emplace(Args&&... args) {
         auto to_write = m_end.load(std::memory_order_relaxed);
         if (next(to_write) == m_start.load(std::memory_order_acquire)) {
             return false;
         }
-        m_arr[to_write] = val;
+        construct(to_write, std::forward<Args>(args)...);
         m_end.store(next(to_write), std::memory_order::release);
         return true;
     }
 
+    bool try_push(const T& val) {
+        return try_emplace(val);
+    }
+
+    bool try_push(T&& val) {
+        return try_emplace(std::move(val));
+    }
+
     bool try_pop(T& val) {
         auto to_pop = m_start.load(std::memory_order_relaxed);
         auto next_end = m_end.load(std::memory_order_acquire);
         if (to_pop == next_end) {
             return false;
         }
-        val = std::move(m_arr[to_pop]);
+        val = take(to_pop);
         m_start.store(next(to_pop), std::memory_order::release);
         return true;
     }
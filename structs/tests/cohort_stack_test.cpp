@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "cohort_stack.h"
+
+class CohortStackTest : public ::testing::Test {
+protected:
+    CohortStack<int> stack;
+};
+
+TEST_F(CohortStackTest, OneCohortPerNode) {
+    EXPECT_EQ(stack.cohorts(), topology::node_count());
+}
+
+TEST_F(CohortStackTest, PushPopSingleThreadTest) {
+    EXPECT_TRUE(stack.empty());
+    stack.push(1);
+    stack.push(2);
+    EXPECT_FALSE(stack.empty());
+
+    // same thread, same cohort: LIFO
+    EXPECT_EQ(stack.pop(), 2);
+    EXPECT_EQ(stack.pop(), 1);
+    EXPECT_TRUE(stack.empty());
+
+    int val;
+    EXPECT_FALSE(stack.try_pop(val));
+}
+
+TEST_F(CohortStackTest, StealFromOtherCohorts) {
+    for (size_t cohort = 0; cohort < stack.cohorts(); ++cohort) {
+        stack.push_to(cohort, int(cohort));
+    }
+
+    std::vector<bool> found(stack.cohorts(), false);
+    int val;
+    while (stack.try_pop(val)) {
+        ASSERT_GE(val, 0);
+        ASSERT_LT(size_t(val), found.size());
+        EXPECT_FALSE(found[val]);
+        found[val] = true;
+    }
+    for (bool was_found : found) {
+        EXPECT_TRUE(was_found);
+    }
+}
+
+TEST_F(CohortStackTest, ConcurrentPushPopTest) {
+    const int num_threads = 4;
+    const int ops_per_thread = 1000;
+    std::atomic<long> sum_pushed(0);
+    std::atomic<long> sum_popped(0);
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < num_threads; ++i) {
+        if (i % 2 == 0) {
+            threads.emplace_back([&]() {
+                for (int j = 0; j < ops_per_thread; ++j) {
+                    stack.push(j + 1);
+                    sum_pushed.fetch_add(j + 1);
+                }
+            });
+        } else {
+            threads.emplace_back([&]() {
+                for (int j = 0; j < ops_per_thread; ++j) {
+                    sum_popped.fetch_add(stack.pop());
+                }
+            });
+        }
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    int val;
+    while (stack.try_pop(val)) {
+        sum_popped.fetch_add(val);
+    }
+    EXPECT_EQ(sum_pushed.load(), sum_popped.load());
+}
@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "lcrq.h"
+
+class LCRQTest : public ::testing::Test {
+protected:
+    static constexpr int NUM_PRODUCERS = 4;
+    static constexpr int NUM_CONSUMERS = 4;
+    static constexpr int ITEMS_PER_PRODUCER = 5000;
+};
+
+TEST_F(LCRQTest, EmptyQueueTest) {
+    LCRQ<int> queue;
+    EXPECT_TRUE(queue.empty());
+
+    int val;
+    EXPECT_FALSE(queue.try_pop(val));
+    // a failed pop must not break later pushes
+    queue.push(1);
+    EXPECT_FALSE(queue.empty());
+    EXPECT_TRUE(queue.try_pop(val));
+    EXPECT_EQ(val, 1);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST_F(LCRQTest, FifoOrderTest) {
+    LCRQ<int> queue;
+    for (int i = 0; i < 100; ++i) {
+        queue.push(i);
+    }
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(queue.pop(), i);
+    }
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST_F(LCRQTest, GrowsPastRingSizeTest) {
+    // a tiny ring forces many CRQs to be closed, appended and retired
+    LCRQ<int, 4> queue;
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 1000; ++i) {
+            queue.push(i);
+        }
+        for (int i = 0; i < 1000; ++i) {
+            ASSERT_EQ(queue.pop(), i);
+        }
+        int val;
+        EXPECT_FALSE(queue.try_pop(val));
+    }
+    rcu_barrier();
+}
+
+TEST_F(LCRQTest, FullWidthValuesTest) {
+    LCRQ<uint64_t> queue;
+    queue.push(0);
+    queue.push(~uint64_t(0));
+    queue.push(uint64_t(1) << 63);
+
+    EXPECT_EQ(queue.pop(), 0);
+    EXPECT_EQ(queue.pop(), ~uint64_t(0));
+    EXPECT_EQ(queue.pop(), uint64_t(1) << 63);
+}
+
+TEST_F(LCRQTest, PointerTest) {
+    LCRQ<int*> queue;
+    int a = 1, b = 2;
+    queue.push(&a);
+    queue.push(&b);
+    EXPECT_EQ(queue.pop(), &a);
+    EXPECT_EQ(queue.pop(), &b);
+}
+
+TEST_F(LCRQTest, NonDefaultConstructibleTest) {
+    struct Ticket {
+        explicit Ticket(uint32_t id): id(id) {}
+        uint32_t id;
+    };
+    static_assert(not std::is_default_constructible_v<Ticket>);
+
+    LCRQ<Ticket> queue;
+    queue.push(Ticket(7));
+    queue.push(Ticket(8));
+    EXPECT_EQ(queue.pop().id, 7u);
+
+    Ticket out(0);
+    EXPECT_TRUE(queue.try_pop(out));
+    EXPECT_EQ(out.id, 8u);
+    EXPECT_FALSE(queue.try_pop(out));
+}
+
+TEST_F(LCRQTest, ConcurrentProducersConsumersTest) {
+    LCRQ<uint64_t, 64> queue;
+    std::atomic<int> consumed(0);
+    std::vector<std::vector<uint64_t>> seen(NUM_CONSUMERS);
+    std::vector<std::thread> threads;
+
+    // items encode (producer, sequence), so per-producer FIFO order can be checked
+    for (int p = 0; p < NUM_PRODUCERS; ++p) {
+        threads.emplace_back([&, p]() {
+            for (uint64_t i = 0; i < ITEMS_PER_PRODUCER; ++i) {
+                queue.push((uint64_t(p) << 32) | i);
+            }
+        });
+    }
+
+    for (int c = 0; c < NUM_CONSUMERS; ++c) {
+        threads.emplace_back([&, c]() {
+            uint64_t val;
+            while (consumed.load() < NUM_PRODUCERS * ITEMS_PER_PRODUCER) {
+                if (queue.try_pop(val)) {
+                    seen[c].push_back(val);
+                    consumed.fetch_add(1);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<std::vector<bool>> found(NUM_PRODUCERS, std::vector<bool>(ITEMS_PER_PRODUCER, false));
+    for (auto& items : seen) {
+        std::vector<int64_t> last(NUM_PRODUCERS, -1);
+        for (auto val : items) {
+            auto p = val >> 32;
+            auto i = int64_t(val & 0xffffffff);
+            ASSERT_LT(p, uint64_t(NUM_PRODUCERS));
+            ASSERT_LT(i, ITEMS_PER_PRODUCER);
+            EXPECT_GT(i, last[p]) << "out of order for producer " << p;
+            last[p] = i;
+            EXPECT_FALSE(found[p][i]) << "duplicate " << p << ":" << i;
+            found[p][i] = true;
+        }
+    }
+    for (auto& producer : found) {
+        for (bool was_found : producer) {
+            EXPECT_TRUE(was_found);
+        }
+    }
+    EXPECT_TRUE(queue.empty());
+    rcu_barrier();
+}
@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "ms_queue.h"
+
+class MSQueueTest : public ::testing::Test {
+protected:
+    static constexpr int NUM_PRODUCERS = 4;
+    static constexpr int NUM_CONSUMERS = 4;
+    static constexpr int ITEMS_PER_PRODUCER = 5000;
+};
+
+TEST_F(MSQueueTest, EmptyQueueTest) {
+    MSQueue<int> queue;
+    EXPECT_TRUE(queue.empty());
+
+    int val;
+    EXPECT_FALSE(queue.try_pop(val));
+    queue.push(1);
+    EXPECT_FALSE(queue.empty());
+    EXPECT_TRUE(queue.try_pop(val));
+    EXPECT_EQ(val, 1);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST_F(MSQueueTest, FifoOrderTest) {
+    MSQueue<int> queue;
+    for (int i = 0; i < 100; ++i) {
+        queue.push(i);
+    }
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(queue.pop(), i);
+    }
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST_F(MSQueueTest, DestroysRemainingValuesTest) {
+    auto tracked = std::make_shared<int>(0);
+    {
+        MSQueue<std::shared_ptr<int>> queue;
+        for (int i = 0; i < 10; ++i) {
+            queue.push(tracked);
+        }
+        EXPECT_EQ(queue.pop(), tracked);
+        EXPECT_EQ(tracked.use_count(), 10);
+    }
+    EXPECT_EQ(tracked.use_count(), 1);
+    rcu_barrier();
+}
+
+TEST_F(MSQueueTest, NonDefaultConstructibleTest) {
+    struct Ticket {
+        explicit Ticket(std::string id): id(std::move(id)) {}
+        std::string id;
+    };
+    static_assert(not std::is_default_constructible_v<Ticket>);
+
+    MSQueue<Ticket> queue;
+    queue.push(Ticket("a"));
+    queue.push(Ticket("b"));
+    EXPECT_EQ(queue.pop().id, "a");
+
+    Ticket out("");
+    EXPECT_TRUE(queue.try_pop(out));
+    EXPECT_EQ(out.id, "b");
+    EXPECT_FALSE(queue.try_pop(out));
+    rcu_barrier();
+}
+
+TEST_F(MSQueueTest, ConcurrentProducersConsumersTest) {
+    MSQueue<uint64_t> queue;
+    std::atomic<int> consumed(0);
+    std::vector<std::vector<uint64_t>> seen(NUM_CONSUMERS);
+    std::vector<std::thread> threads;
+
+    // items encode (producer, sequence), so per-producer FIFO order can be checked
+    for (int p = 0; p < NUM_PRODUCERS; ++p) {
+        threads.emplace_back([&, p]() {
+            for (uint64_t i = 0; i < ITEMS_PER_PRODUCER; ++i) {
+                queue.push((uint64_t(p) << 32) | i);
+            }
+        });
+    }
+
+    for (int c = 0; c < NUM_CONSUMERS; ++c) {
+        threads.emplace_back([&, c]() {
+            uint64_t val;
+            while (consumed.load() < NUM_PRODUCERS * ITEMS_PER_PRODUCER) {
+                if (queue.try_pop(val)) {
+                    seen[c].push_back(val);
+                    consumed.fetch_add(1);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<std::vector<bool>> found(NUM_PRODUCERS, std::vector<bool>(ITEMS_PER_PRODUCER, false));
+    for (auto& items : seen) {
+        std::vector<int64_t> last(NUM_PRODUCERS, -1);
+        for (auto val : items) {
+            auto p = val >> 32;
+            auto i = int64_t(val & 0xffffffff);
+            ASSERT_LT(p, uint64_t(NUM_PRODUCERS));
+            ASSERT_LT(i, ITEMS_PER_PRODUCER);
+            EXPECT_GT(i, last[p]) << "out of order for producer " << p;
+            last[p] = i;
+            EXPECT_FALSE(found[p][i]) << "duplicate " << p << ":" << i;
+            found[p][i] = true;
+        }
+    }
+    for (auto& producer : found) {
+        for (bool was_found : producer) {
+            EXPECT_TRUE(was_found);
+        }
+    }
+    EXPECT_TRUE(queue.empty());
+    rcu_barrier();
+}
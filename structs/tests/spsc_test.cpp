@@ -3,6 +3,8 @@
 #include <thread>
 #include <vector>
 #include <chrono>
+#include <memory>
+#include <string>
 
 TEST(RingBufferTest, BasicOperations) {
     RingBuffer<int, 4> buffer; // Size 4 means capacity of 3 due to reserved slot
@@ -125,4 +127,93 @@ TEST(RingBufferTest, StressTest) {
     
     producer.join();
     consumer.join();
-} 
\ No newline at end of file
+}
+
+TEST(RingBufferTest, MoveOnlyType) {
+    RingBuffer<std::unique_ptr<int>, 4> buffer;
+
+    buffer.push(std::make_unique<int>(1));
+    EXPECT_TRUE(buffer.try_push(std::make_unique<int>(2)));
+    buffer.emplace(new int(3));
+    EXPECT_FALSE(buffer.try_emplace(new int(4))); // full, nothing constructed
+
+    EXPECT_EQ(*buffer.pop(), 1);
+    std::unique_ptr<int> val;
+    EXPECT_TRUE(buffer.try_pop(val));
+    EXPECT_EQ(*val, 2);
+    EXPECT_EQ(*buffer.pop(), 3);
+    EXPECT_TRUE(buffer.empty());
+}
+
+TEST(RingBufferTest, NonDefaultConstructibleType) {
+    struct Frame {
+        int id;
+        std::string name;
+        Frame(int id, std::string name): id(id), name(std::move(name)) {}
+    };
+
+    RingBuffer<Frame, 3> buffer;
+    buffer.emplace(1, "first");
+    EXPECT_TRUE(buffer.try_emplace(2, "second"));
+
+    auto first = buffer.pop();
+    EXPECT_EQ(first.id, 1);
+    EXPECT_EQ(first.name, "first");
+    EXPECT_EQ(buffer.pop().name, "second");
+}
+
+struct Tracked {
+    static inline int live = 0;
+    int val;
+
+    explicit Tracked(int val): val(val) { ++live; }
+    Tracked(const Tracked& other): val(other.val) { ++live; }
+    Tracked(Tracked&& other) noexcept: val(other.val) { ++live; }
+    Tracked& operator=(const Tracked&) = default;
+    Tracked& operator=(Tracked&&) noexcept = default;
+    ~Tracked() { --live; }
+};
+
+TEST(RingBufferTest, ElementLifetime) {
+    Tracked::live = 0;
+    {
+        RingBuffer<Tracked, 8> buffer;
+        EXPECT_EQ(Tracked::live, 0); // no element constructed up front
+
+        for (int i = 0; i < 5; ++i) {
+            buffer.emplace(i);
+        }
+        EXPECT_EQ(Tracked::live, 5);
+
+        {
+            auto val = buffer.pop();
+            EXPECT_EQ(val.val, 0);
+            EXPECT_EQ(Tracked::live, 5); // slot destroyed, value moved out
+        }
+        EXPECT_EQ(Tracked::live, 4);
+    }
+    // remaining elements are destroyed with the buffer
+    EXPECT_EQ(Tracked::live, 0);
+}
+
+TEST(RingBufferTest, MoveOnlyThreadSafety) {
+    RingBuffer<std::unique_ptr<int>, 1024> buffer;
+    const int num_operations = 10000;
+
+    std::thread producer([&]() {
+        for (int i = 0; i < num_operations; ++i) {
+            buffer.emplace(std::make_unique<int>(i));
+        }
+    });
+
+    std::thread consumer([&]() {
+        for (int i = 0; i < num_operations; ++i) {
+            auto val = buffer.pop();
+            ASSERT_NE(val, nullptr);
+            EXPECT_EQ(*val, i);
+        }
+    });
+
+    producer.join();
+    consumer.join();
+}
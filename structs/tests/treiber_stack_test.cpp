@@ -2,6 +2,7 @@
 #include <thread>
 #include <vector>
 #include "treiber_stack.h"
+#include "topology.hpp"
 
 class TreiberStackTest : public ::testing::Test {
 protected:
@@ -103,4 +104,118 @@ TEST_F(TreiberStackTest, ConcurrentPushPopTest) {
     
     // Verify total sum pushed equals total sum popped
     EXPECT_EQ(sum_pushed.load(), sum_popped.load());
-} 
\ No newline at end of file
+}
+
+TEST_F(TreiberStackTest, TryPopTest) {
+    int val = 0;
+    EXPECT_FALSE(stack.try_pop(val));
+
+    stack.push(1);
+    stack.push(2);
+    EXPECT_TRUE(stack.try_pop(val));
+    EXPECT_EQ(val, 2);
+    EXPECT_TRUE(stack.try_pop(val));
+    EXPECT_EQ(val, 1);
+    EXPECT_FALSE(stack.try_pop(val));
+}
+
+TEST(TreiberStackAllocatorTest, NodeAllocatorTest) {
+    Stack<int, topology::NodeAllocator<int>> stack(topology::NodeAllocator<int>(topology::nodes().front()));
+    for (int i = 0; i < 100; ++i) {
+        stack.push(i);
+    }
+    for (int i = 99; i >= 0; --i) {
+        EXPECT_EQ(stack.pop(), i);
+    }
+    EXPECT_TRUE(stack.empty());
+}
+
+TEST(TreiberStackReclaimTest, ConcurrentPushPopStressTest) {
+    // every thread pushes and pops its own tagged values, so each value must come
+    // back exactly once. Popped nodes go through rcu while other poppers may still
+    // be reading them, and pushers publish nodes that are popped right away.
+    const int num_threads = 4;
+    const int ops_per_thread = 20000;
+    Stack<uint64_t> stack;
+    std::vector<std::vector<bool>> seen(num_threads, std::vector<bool>(ops_per_thread, false));
+    std::vector<std::vector<uint64_t>> popped(num_threads);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&, t]() {
+            uint64_t val;
+            for (uint64_t i = 0; i < ops_per_thread; ++i) {
+                stack.push((uint64_t(t) << 32) | i);
+                if (stack.try_pop(val)) popped[t].push_back(val);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    uint64_t val;
+    while (stack.try_pop(val)) popped[0].push_back(val);
+
+    size_t total = 0;
+    for (auto& values : popped) {
+        for (auto v : values) {
+            auto t = v >> 32;
+            auto i = v & 0xffffffff;
+            ASSERT_LT(t, uint64_t(num_threads));
+            ASSERT_LT(i, uint64_t(ops_per_thread));
+            EXPECT_FALSE(seen[t][i]) << "duplicate " << t << ":" << i;
+            seen[t][i] = true;
+            ++total;
+        }
+    }
+    EXPECT_EQ(total, size_t(num_threads) * ops_per_thread);
+}
+
+TEST(TreiberStackReclaimTest, DestroyWhileOtherStackRetires) {
+    // stack A keeps retiring nodes into the shared call_rcu queue while node-bound
+    // stacks are created and destroyed next to it. The queued freeNode callbacks of a
+    // destroyed stack must not read anything from the (now unmapped) stack.
+    Stack<int> a;
+    std::atomic<bool> stop(false);
+
+    std::thread retirer([&]() {
+        int val;
+        while (!stop) {
+            a.push(1);
+            a.try_pop(val);
+        }
+    });
+
+    using NodeStack = Stack<int, topology::NodeAllocator<int>>;
+    int node = topology::nodes().front();
+    for (int round = 0; round < 100; ++round) {
+        auto b = topology::make_on_node<NodeStack>(node, topology::NodeAllocator<int>(node));
+        for (int i = 0; i < 20; ++i) {
+            b->push(i);
+        }
+        int val;
+        while (b->try_pop(val));
+    }
+
+    stop = true;
+    retirer.join();
+}
+
+TEST(TreiberStackReclaimTest, StackFreedByRcuCallback) {
+    // how an rcu_ptr-owned object holding a Stack gets freed: the stack is deleted by a
+    // callback that may share a batch with the stack's own retired nodes
+    using NodeStack = Stack<int, topology::NodeAllocator<int>>;
+    int node = topology::nodes().front();
+    for (int round = 0; round < 100; ++round) {
+        auto* stack = new NodeStack(topology::NodeAllocator<int>(node));
+        stack->push(1);
+        {
+            rcu_read_guard guard; // the stack stays alive until the section ends
+            call_rcu([stack]() { delete stack; });
+            int val;
+            EXPECT_TRUE(stack->try_pop(val));
+        }
+        rcu_barrier();
+    }
+}
@@ -17,12 +17,21 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#pragma once
+
 #include "atomic.hpp"
+#include "rcu.hpp"
+#include <memory>
 
 // This is a lock-free thread-safe stack.
-// Note that this stack still have the use-after-free issue. 
-// TODO: impl hazard pointer or type-based memory collector to resolve this issue.
-template <typename T>
+// Popped nodes are reclaimed through rcu: a popper dereferences the top node only inside
+// a read-side section, and nodes are freed with call_rcu, so no node is freed while
+// another popper may still be reading its next pointer. call_rcu only enqueues; grace
+// periods run on rcu's reclaimer thread, so push and pop never wait for other threads.
+// @tparam Alloc: allocator used for the nodes. Pass topology::NodeAllocator to keep
+//                nodes on the socket of the threads using the stack; nodes then come
+//                from that node's NodePool.
+template <typename T, typename Alloc = std::allocator<T>>
 class Stack
 {
 private:
@@ -38,6 +47,9 @@ private:
         Node(T val, CountedPointer next): val(std::move(val)), next(std::move(next)) {}
     };
 
+    using NodeAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Node>;
+    using NodeAllocTraits = std::allocator_traits<NodeAlloc>;
+
     struct CountedPointerUtils
     {
         using Base = uint128_t;
@@ -68,10 +80,43 @@ private:
     AtomicCountedPointer m_top;
     std::atomic<uint64_t> m_counter; // counter is used for counted pointer.
     std::atomic<size_t> m_size;
+    NodeAlloc m_alloc;
+
+    Node* allocNode(const T& val, CountedPointer next)
+    {
+        Node* node = NodeAllocTraits::allocate(m_alloc, 1);
+        NodeAllocTraits::construct(m_alloc, node, val, next);
+        return node;
+    }
+
+    static void freeNode(NodeAlloc& alloc, Node* node)
+    {
+        NodeAllocTraits::destroy(alloc, node);
+        NodeAllocTraits::deallocate(alloc, node, 1);
+    }
+
+    // free `node` once no concurrent popper can still be reading it.
+    // The callback owns a copy of the allocator, so the stack may be gone by the time it runs.
+    void retireNode(Node* node)
+    {
+        call_rcu([alloc = m_alloc, node]() mutable { freeNode(alloc, node); });
+    }
+
+    // unlink the top node
+    // @return the unlinked node, now owned by the caller, or nullptr if the stack was empty
+    Node* unlinkTop()
+    {
+        rcu_read_guard guard;
+        auto oldTop = m_top.load(std::memory_order_acquire);
+        while (not CountedPointerUtils::isNull(oldTop) && not CountedPointerUtils::cas(m_top, oldTop, CountedPointerUtils::pointer(oldTop)->next));
+        return CountedPointerUtils::pointer(oldTop);
+    }
 
 public:
     Stack() = default;
 
+    explicit Stack(const Alloc& alloc): m_alloc(alloc) {}
+
     ~Stack() {
         // destructor should be only called once, and only when no thread is using the stack!
         CountedPointer cachedTop = m_top.load();
@@ -79,7 +124,7 @@ public:
         {
             auto nextTop = CountedPointerUtils::pointer(cachedTop)->next;
             assert(CountedPointerUtils::cas(m_top, cachedTop, nextTop));
-            delete CountedPointerUtils::pointer(cachedTop);
+            freeNode(m_alloc, CountedPointerUtils::pointer(cachedTop));
             cachedTop = nextTop;
         }
     }
@@ -91,7 +136,7 @@ public:
 
     void push(const T& val)
     {
-        Node* node = new Node(val, m_top.load(std::memory_order_acquire));
+        Node* node = allocNode(val, m_top.load(std::memory_order_acquire));
         CountedPointer newNode = CountedPointerUtils::newPointer(node, m_counter.fetch_add(1, std::memory_order_relaxed) + 1);
 
         // here the new node won't be released until a thread success.
@@ -103,18 +148,27 @@ public:
 
     T pop()
     {
-        auto oldTop = m_top.load();
-        while (true)
-        {
-            while (CountedPointerUtils::isNull(oldTop)) oldTop = m_top.load(std::memory_order_acquire); // block if nothing is there
-            while (not CountedPointerUtils::isNull(oldTop) && not CountedPointerUtils::cas(m_top, oldTop, CountedPointerUtils::pointer(oldTop)->next));
+        Node* node;
+        // block if nothing is there. The read-side section is not held while spinning.
+        while ((node = unlinkTop()) == nullptr);
 
-            if (not CountedPointerUtils::isNull(oldTop)) break;
-        }
         m_size.fetch_sub(1);
-        T result = CountedPointerUtils::pointer(oldTop)->val;
-        delete CountedPointerUtils::pointer(oldTop);
+        T result = node->val;
+        retireNode(node);
 
         return result;
     }
+
+    // non-blocking pop
+    // @return false if the stack was empty at the time of the attempt
+    bool try_pop(T& val)
+    {
+        Node* node = unlinkTop();
+        if (node == nullptr) return false;
+
+        m_size.fetch_sub(1);
+        val = node->val;
+        retireNode(node);
+        return true;
+    }
 };
\ No newline at end of file